@@ -7,6 +7,9 @@
 #include "threads/interrupt.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
+#ifdef USERPROG
+#include "userprog/vdso.h"
+#endif
   
 /* See [8254] for hardware details of the 8254 timer chip. */
 
@@ -172,6 +175,9 @@ static void
 timer_interrupt (struct intr_frame *args UNUSED)
 {
   ticks++;
+#ifdef USERPROG
+  vdso_tick (ticks);
+#endif
   thread_tick ();
   wakeup_threads(ticks);
 }
@@ -0,0 +1,41 @@
+/* clockbench.c
+
+   Compares the cost of reading the time through the gettime
+   system call with reading it from the vDSO page. */
+
+#include <clock.h>
+#include <stdio.h>
+#include <syscall.h>
+
+#define CALLS 10000
+
+/* Returns the CPU's time-stamp counter. */
+static inline unsigned long long
+rdtsc (void)
+{
+  unsigned long long tsc;
+  asm volatile ("rdtsc" : "=A" (tsc));
+  return tsc;
+}
+
+int
+main (void)
+{
+  unsigned long long start;
+  uint64_t ns;
+  int i;
+
+  start = rdtsc ();
+  for (i = 0; i < CALLS; i++)
+    gettime (&ns);
+  printf ("gettime: %llu cycles per call\n", (rdtsc () - start) / CALLS);
+
+  start = rdtsc ();
+  for (i = 0; i < CALLS; i++)
+    ns = clock_ns ();
+  printf ("clock_ns: %llu cycles per call\n", (rdtsc () - start) / CALLS);
+
+  printf ("%llu ns, %lld ticks since boot\n",
+          (unsigned long long) ns, (long long) clock_ticks ());
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,65 @@
+/* nullcall.c
+
+   Measures the cost of a system call that does no work, made
+   first with "int $0x30" and then, if the kernel was started
+   with -sysenter, with SYSENTER. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include <syscall-nr.h>
+
+#define CALLS 10000
+
+/* Returns the CPU's time-stamp counter. */
+static inline unsigned long long
+rdtsc (void)
+{
+  unsigned long long tsc;
+  asm volatile ("rdtsc" : "=A" (tsc));
+  return tsc;
+}
+
+/* Makes the SYS_SYSENTER system call with "int $0x30" and
+   returns its result. */
+static inline int
+null_int (void)
+{
+  int retval;
+  asm volatile ("pushl %[number]; int $0x30; addl $4, %%esp"
+                : "=a" (retval) : [number] "i" (SYS_SYSENTER) : "memory");
+  return retval;
+}
+
+/* Makes the SYS_SYSENTER system call with SYSENTER. */
+static inline void
+null_sysenter (void)
+{
+  asm volatile ("pushl %[number]; movl %%esp, %%ecx; movl $1f, %%edx; "
+                "sysenter; 1: addl $4, %%esp"
+                : : [number] "i" (SYS_SYSENTER)
+                : "eax", "ecx", "edx", "memory");
+}
+
+int
+main (void)
+{
+  unsigned long long start;
+  int i;
+
+  start = rdtsc ();
+  for (i = 0; i < CALLS; i++)
+    null_int ();
+  printf ("int $0x30: %llu cycles per call\n", (rdtsc () - start) / CALLS);
+
+  if (!null_int ())
+    {
+      printf ("sysenter: disabled (boot with -sysenter)\n");
+      return EXIT_SUCCESS;
+    }
+
+  start = rdtsc ();
+  for (i = 0; i < CALLS; i++)
+    null_sysenter ();
+  printf ("sysenter: %llu cycles per call\n", (rdtsc () - start) / CALLS);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,97 @@
+/* ringcp.c
+
+Copies one file to another, like cp, but queues its reads and
+writes in a ring so that one ring_enter() system call carries
+out many of them. */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <syscall.h>
+
+/* Each read and the write of the same data form a pair. */
+#define PAIR_CNT (RING_ENTRIES / 2)
+
+static struct ring ring;
+static char buffers[PAIR_CNT][1024];
+
+/* Queues a request to carry out OP on FD and BUF. */
+static void
+submit (int op, int flags, int fd, void *buf, unsigned size) 
+{
+  struct ring_sqe *sqe = &ring.sq[ring.sq_tail % RING_ENTRIES];
+  sqe->op = op;
+  sqe->flags = flags;
+  sqe->fd = fd;
+  sqe->buf = buf;
+  sqe->size = size;
+  sqe->user_data = ring.sq_tail++;
+}
+
+int
+main (int argc, char *argv[]) 
+{
+  int in_fd, out_fd;
+  bool eof;
+
+  if (argc != 3) 
+    {
+      printf ("usage: ringcp OLD NEW\n");
+      return EXIT_FAILURE;
+    }
+
+  /* Open input file. */
+  in_fd = open (argv[1]);
+  if (in_fd < 0) 
+    {
+      printf ("%s: open failed\n", argv[1]);
+      return EXIT_FAILURE;
+    }
+
+  /* Create and open output file. */
+  if (!create (argv[2], filesize (in_fd))) 
+    {
+      printf ("%s: create failed\n", argv[2]);
+      return EXIT_FAILURE;
+    }
+  out_fd = open (argv[2]);
+  if (out_fd < 0) 
+    {
+      printf ("%s: open failed\n", argv[2]);
+      return EXIT_FAILURE;
+    }
+
+  /* Copy data, a ring full of reads and writes at a time.  Each
+     write is linked to the read before it, so it writes as many
+     bytes as were read. */
+  for (eof = false; !eof; ) 
+    {
+      int i;
+
+      for (i = 0; i < PAIR_CNT; i++) 
+        {
+          submit (RING_READ, 0, in_fd, buffers[i], sizeof buffers[i]);
+          submit (RING_WRITE, RING_LINK, out_fd, buffers[i], 0);
+        }
+      ring_enter (&ring);
+
+      while (ring.cq_head != ring.cq_tail) 
+        {
+          struct ring_cqe *read = &ring.cq[ring.cq_head++ % RING_ENTRIES];
+          struct ring_cqe *write = &ring.cq[ring.cq_head++ % RING_ENTRIES];
+          if (read->result < 0) 
+            {
+              printf ("%s: read failed\n", argv[1]);
+              return EXIT_FAILURE;
+            }
+          if (read->result < (int) sizeof buffers[0])
+            eof = true;
+          if (write->result != read->result) 
+            {
+              printf ("%s: write failed\n", argv[2]);
+              return EXIT_FAILURE;
+            }
+        }
+    }
+
+  return EXIT_SUCCESS;
+}
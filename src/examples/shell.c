@@ -3,8 +3,13 @@
 #include <string.h>
 #include <syscall.h>
 
+/* Maximum number of commands in a pipeline. */
+#define MAX_STAGES 8
+
 static void read_line (char line[], size_t);
 static bool backspace (char **pos, char line[]);
+static void run_pipeline (char *command);
+static char *trim (char *);
 
 int
 main (void)
@@ -31,19 +36,95 @@ main (void)
           /* Empty command. */
         }
       else
-        {
-          pid_t pid = exec (command);
-          if (pid != PID_ERROR)
-            printf ("\"%s\": exit code %d\n", command, wait (pid));
-          else
-            printf ("exec failed\n");
-        }
+        run_pipeline (command);
     }
 
   printf ("Shell exiting.");
   return EXIT_SUCCESS;
 }
 
+/* Runs COMMAND, which may be a series of commands separated by
+   `|', with the output of each command piped into the input of
+   the next, and prints the exit code of each. */
+static void
+run_pipeline (char *command) 
+{
+  char *cmds[MAX_STAGES];
+  pid_t pids[MAX_STAGES];
+  int cmd_cnt = 0;
+  int in_fd = -1;
+  char *cmd, *save_ptr;
+  int i;
+
+  for (cmd = strtok_r (command, "|", &save_ptr); cmd != NULL;
+       cmd = strtok_r (NULL, "|", &save_ptr)) 
+    {
+      if (cmd_cnt >= MAX_STAGES) 
+        {
+          printf ("too many commands in pipeline\n");
+          return;
+        }
+      cmds[cmd_cnt++] = trim (cmd);
+    }
+
+  /* Start each command with its standard input and output
+     redirected as needed.  Children inherit the shell's
+     redirected standard handles, so redirect them around each
+     exec() and then close them again to get the console back. */
+  for (i = 0; i < cmd_cnt; i++) 
+    {
+      bool piped = i + 1 < cmd_cnt;
+      int fds[2];
+
+      if (piped && !pipe (fds)) 
+        {
+          printf ("pipe failed\n");
+          if (in_fd >= 0)
+            close (in_fd);
+          cmd_cnt = i;
+          break;
+        }
+
+      if (in_fd >= 0)
+        dup2 (in_fd, STDIN_FILENO);
+      if (piped)
+        dup2 (fds[1], STDOUT_FILENO);
+      pids[i] = exec (cmds[i]);
+      if (in_fd >= 0) 
+        {
+          close (STDIN_FILENO);
+          close (in_fd);
+        }
+      if (piped) 
+        {
+          close (STDOUT_FILENO);
+          close (fds[1]);
+        }
+      in_fd = piped ? fds[0] : -1;
+    }
+
+  for (i = 0; i < cmd_cnt; i++)
+    if (pids[i] != PID_ERROR)
+      printf ("\"%s\": exit code %d\n", cmds[i], wait (pids[i]));
+    else
+      printf ("exec failed\n");
+}
+
+/* Removes leading and trailing spaces from S, in place, and
+   returns the result. */
+static char *
+trim (char *s) 
+{
+  char *end;
+
+  while (*s == ' ')
+    s++;
+  end = s + strlen (s);
+  while (end > s && end[-1] == ' ')
+    *--end = '\0';
+  return s;
+}
+
 /* Reads a line of input from the user into LINE, which has room
    for SIZE bytes.  Handles backspace and Ctrl+U in the ways
    expected by Unix users.  On return, LINE will always be
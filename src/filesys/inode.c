@@ -36,6 +36,7 @@ struct inode
     int open_cnt;                       /* Number of openers. */
     bool removed;                       /* True if deleted, false otherwise. */
     int deny_write_cnt;                 /* 0: writes ok, >0: deny writes. */
+    unsigned generation;                /* Incremented by every write. */
     struct inode_disk data;             /* Inode content. */
   };
 
@@ -136,6 +137,7 @@ inode_open (block_sector_t sector)
   inode->sector = sector;
   inode->open_cnt = 1;
   inode->deny_write_cnt = 0;
+  inode->generation = 0;
   inode->removed = false;
   block_read (fs_device, inode->sector, &inode->data);
   return inode;
@@ -157,6 +159,15 @@ inode_get_inumber (const struct inode *inode)
   return inode->sector;
 }
 
+/* Returns INODE's generation, which changes whenever INODE is
+   written, so that data derived from its contents can be checked
+   for staleness.  Only meaningful while INODE stays open. */
+unsigned
+inode_get_generation (const struct inode *inode)
+{
+  return inode->generation;
+}
+
 /* Closes INODE and writes it to disk.
    If this was the last reference to INODE, frees its memory.
    If INODE was also a removed inode, frees its blocks. */
@@ -264,6 +275,8 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 
   if (inode->deny_write_cnt)
     return 0;
+  if (size > 0)
+    inode->generation++;
 
   while (size > 0) 
     {
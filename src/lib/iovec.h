@@ -0,0 +1,16 @@
+#ifndef __LIB_IOVEC_H
+#define __LIB_IOVEC_H
+
+#include <stddef.h>
+
+/* A buffer for the readv and writev system calls. */
+struct iovec
+  {
+    void *iov_base;             /* Start of buffer. */
+    size_t iov_len;             /* Length of buffer, in bytes. */
+  };
+
+/* Most buffers that readv or writev accepts in one call. */
+#define IOV_MAX 32
+
+#endif /* lib/iovec.h */
@@ -0,0 +1,151 @@
+#include "lz.h"
+#include <debug.h>
+#include <string.h>
+
+/* Match limits, in bytes.  See lz.h for the encoding. */
+#define MIN_MATCH 3
+#define MAX_MATCH (MIN_MATCH + 15 + 255)
+#define MAX_OFFSET 4096
+
+/* The compressor finds matches through a hash table of
+   1 << HASH_BITS entries, indexed by a hash of the next
+   MIN_MATCH bytes, each holding 1 + the position at which those
+   bytes last occurred, or 0. */
+#define HASH_BITS 12
+
+/* Returns the hash table index for the MIN_MATCH bytes at P. */
+static inline unsigned
+hash3 (const uint8_t *p)
+{
+  uint32_t x = p[0] | (p[1] << 8) | ((uint32_t) p[2] << 16);
+  return (x * 2654435761u) >> (32 - HASH_BITS);
+}
+
+/* Compresses the SRC_SIZE bytes at SRC into the DST_SIZE bytes
+   at DST, using WORK, which must be LZ_WORK_SIZE bytes, as
+   scratch space.  Returns the size of the compressed data, or 0
+   if it would not fit in DST_SIZE bytes.  SRC_SIZE must be less
+   than 65,535. */
+size_t
+lz_compress (const void *src_, size_t src_size,
+             void *dst_, size_t dst_size, void *work)
+{
+  const uint8_t *src = src_;
+  uint8_t *dst = dst_;
+  uint16_t *table = work;
+  size_t in = 0, out = 0;
+  size_t flag_ofs = 0;
+  int item = 8;
+
+  ASSERT (src_size < UINT16_MAX);
+
+  memset (table, 0, LZ_WORK_SIZE);
+  while (in < src_size)
+    {
+      size_t length = 0, offset = 0;
+
+      /* Start a new group if the last one is full. */
+      if (item == 8)
+        {
+          if (out >= dst_size)
+            return 0;
+          flag_ofs = out;
+          dst[out++] = 0;
+          item = 0;
+        }
+
+      /* Look for a match at the position these bytes were last
+         seen. */
+      if (src_size - in >= MIN_MATCH)
+        {
+          unsigned h = hash3 (src + in);
+          size_t cand = table[h];
+          table[h] = in + 1;
+
+          if (cand != 0 && in - (cand - 1) <= MAX_OFFSET)
+            {
+              size_t max = src_size - in;
+              const uint8_t *p = src + cand - 1;
+
+              if (max > MAX_MATCH)
+                max = MAX_MATCH;
+              while (length < max && p[length] == src[in + length])
+                length++;
+              offset = in - (cand - 1);
+            }
+        }
+
+      if (length >= MIN_MATCH)
+        {
+          size_t code = length - MIN_MATCH;
+
+          if (out + (code >= 15 ? 3 : 2) > dst_size)
+            return 0;
+          dst[flag_ofs] |= 1 << item;
+          dst[out++] = (offset - 1) & 0xff;
+          dst[out++] = ((offset - 1) >> 8) << 4 | (code < 15 ? code : 15);
+          if (code >= 15)
+            dst[out++] = code - 15;
+          in += length;
+        }
+      else
+        {
+          if (out >= dst_size)
+            return 0;
+          dst[out++] = src[in++];
+        }
+      item++;
+    }
+  return out;
+}
+
+/* Decompresses the SRC_SIZE bytes of compressed data at SRC into
+   the DST_SIZE bytes at DST.  Returns the size of the
+   decompressed data, or 0 if the compressed data is corrupt or
+   would decompress to more than DST_SIZE bytes. */
+size_t
+lz_decompress (const void *src_, size_t src_size,
+               void *dst_, size_t dst_size)
+{
+  const uint8_t *src = src_;
+  uint8_t *dst = dst_;
+  size_t in = 0, out = 0;
+
+  while (in < src_size)
+    {
+      uint8_t flags = src[in++];
+      int item;
+
+      for (item = 0; item < 8 && in < src_size; item++)
+        if (flags & (1 << item))
+          {
+            size_t offset, length;
+
+            if (src_size - in < 2)
+              return 0;
+            offset = (src[in] | (src[in + 1] >> 4 << 8)) + 1;
+            length = (src[in + 1] & 15) + MIN_MATCH;
+            in += 2;
+            if (length == MIN_MATCH + 15)
+              {
+                if (in >= src_size)
+                  return 0;
+                length += src[in++];
+              }
+            if (offset > out || length > dst_size - out)
+              return 0;
+
+            /* The source and destination may overlap, which is
+               how runs are encoded, so copy byte by byte. */
+            for (; length > 0; length--, out++)
+              dst[out] = dst[out - offset];
+          }
+        else
+          {
+            if (out >= dst_size)
+              return 0;
+            dst[out++] = src[in++];
+          }
+    }
+  return out;
+}
@@ -0,0 +1,32 @@
+#ifndef __LIB_KERNEL_LZ_H
+#define __LIB_KERNEL_LZ_H
+
+/* LZ77-family compression.
+
+   A small, fast codec in the style of LZSS, meant for compressing
+   pages in memory rather than for a good compression ratio.  The
+   compressed data is a sequence of groups, each a flag byte
+   followed by up to 8 items, one per flag bit starting from the
+   least significant.  A 0 bit marks a literal byte, copied as
+   is.  A 1 bit marks a match, a copy of earlier output encoded
+   in 2 or 3 bytes:
+
+        byte 0: low 8 bits of (offset - 1)
+        byte 1: high 4 bits of (offset - 1), then (length - 3)
+        byte 2: (length - 18), present only if (length - 3) is 15
+
+   so that matches reach back up to 4,096 bytes and run from 3
+   to 273 bytes long. */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Size of the work area that lz_compress() needs, in bytes. */
+#define LZ_WORK_SIZE (sizeof (uint16_t) << 12)
+
+size_t lz_compress (const void *src, size_t src_size,
+                    void *dst, size_t dst_size, void *work);
+size_t lz_decompress (const void *src, size_t src_size,
+                      void *dst, size_t dst_size);
+
+#endif /* lib/kernel/lz.h */
@@ -0,0 +1,10 @@
+#ifndef __LIB_MADVISE_H
+#define __LIB_MADVISE_H
+
+/* Advice for the madvise system call. */
+#define MADV_NORMAL 0           /* No special treatment. */
+#define MADV_SEQUENTIAL 1       /* Expect sequential access. */
+#define MADV_WILLNEED 2         /* Expect access soon. */
+#define MADV_DONTNEED 3         /* Contents no longer needed. */
+
+#endif /* lib/madvise.h */
@@ -0,0 +1,59 @@
+#ifndef __LIB_RING_H
+#define __LIB_RING_H
+
+#include <stdint.h>
+
+/* A submission and completion ring for the ring_enter system
+   call, which lets a process queue up many file operations and
+   have them all carried out by a single system call.
+
+   The process adds requests to the submission queue and advances
+   SQ_TAIL, then calls ring_enter().  The kernel carries out
+   requests in order from SQ_HEAD, posting a completion for each
+   at CQ_TAIL, until the submission queue is empty or the
+   completion queue is full.  The process consumes completions
+   from CQ_HEAD.  All four indexes run freely and are reduced
+   modulo RING_ENTRIES only to index the arrays. */
+
+/* Number of entries in each queue.  Must be a power of 2. */
+#define RING_ENTRIES 64
+
+/* Operations. */
+#define RING_OPEN 0             /* open (buf). */
+#define RING_READ 1             /* read (fd, buf, size). */
+#define RING_WRITE 2            /* write (fd, buf, size). */
+#define RING_SEEK 3             /* seek (fd, size). */
+#define RING_CLOSE 4            /* close (fd). */
+
+/* Submission flags. */
+#define RING_LINK 0x1           /* Use previous request's result as size. */
+
+/* A request. */
+struct ring_sqe
+  {
+    uint8_t op;                 /* One of RING_*. */
+    uint8_t flags;              /* RING_LINK or 0. */
+    int fd;                     /* File descriptor. */
+    void *buf;                  /* Buffer, or file name for RING_OPEN. */
+    unsigned size;              /* Size, or position for RING_SEEK. */
+    uint32_t user_data;         /* Copied to the completion. */
+  };
+
+/* A completion. */
+struct ring_cqe
+  {
+    uint32_t user_data;         /* From the request. */
+    int result;                 /* Return value, or 0 if none. */
+  };
+
+struct ring
+  {
+    unsigned sq_head;           /* Next request; advanced by kernel. */
+    unsigned sq_tail;           /* End of requests; advanced by process. */
+    unsigned cq_head;           /* Next completion; advanced by process. */
+    unsigned cq_tail;           /* End of completions; advanced by kernel. */
+    struct ring_sqe sq[RING_ENTRIES];
+    struct ring_cqe cq[RING_ENTRIES];
+  };
+
+#endif /* lib/ring.h */
@@ -0,0 +1,16 @@
+#ifndef __LIB_RUSAGE_H
+#define __LIB_RUSAGE_H
+
+/* Paging statistics for a process, as reported by the getrusage
+   system call. */
+struct rusage
+  {
+    unsigned minor_faults;      /* Faults handled without disk I/O. */
+    unsigned major_faults;      /* Faults that waited for disk I/O. */
+    unsigned evictions;         /* Pages evicted from memory. */
+    unsigned swap_ins;          /* Pages brought back from swap. */
+    unsigned resident_pages;    /* Pages currently in memory. */
+    unsigned working_set;       /* Pages touched in last sample period. */
+  };
+
+#endif /* lib/rusage.h */
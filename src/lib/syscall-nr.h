@@ -28,7 +28,21 @@ enum
     SYS_MKDIR,                  /* Create a directory. */
     SYS_READDIR,                /* Reads a directory entry. */
     SYS_ISDIR,                  /* Tests if a fd represents a directory. */
-    SYS_INUMBER                 /* Returns the inode number for a fd. */
+    SYS_INUMBER,                /* Returns the inode number for a fd. */
+
+    /* Extensions. */
+    SYS_GETRUSAGE,              /* Report paging statistics. */
+    SYS_MADVISE,                /* Advise on expected memory use. */
+    SYS_SYSENTER,               /* Report whether SYSENTER may be used. */
+    SYS_READV,                  /* Read from a file into several buffers. */
+    SYS_WRITEV,                 /* Write several buffers to a file. */
+    SYS_RING_ENTER,             /* Carry out requests queued in a ring. */
+    SYS_COPY_FILE_RANGE,        /* Copy data from one file to another. */
+    SYS_PIPE,                   /* Create a pipe. */
+    SYS_DUP2,                   /* Duplicate a file descriptor. */
+    SYS_GETTIME,                /* Get the time since boot. */
+    SYS_SBRK,                   /* Grow or shrink the heap. */
+    SYS_SPAWN                   /* Start a process with given handles. */
   };
 
 #endif /* lib/syscall-nr.h */
@@ -0,0 +1,16 @@
+#include <clock.h>
+#include <vdso.h>
+
+/* Returns the number of timer ticks since the OS booted. */
+int64_t
+clock_ticks (void)
+{
+  return vdso_read_ticks (VDSO_ADDR);
+}
+
+/* Returns the number of nanoseconds since the OS booted. */
+uint64_t
+clock_ns (void)
+{
+  return vdso_read_ns (VDSO_ADDR);
+}
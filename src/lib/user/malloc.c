@@ -0,0 +1,390 @@
+#include <malloc.h>
+#include <debug.h>
+#include <round.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <syscall.h>
+
+/* A user-space memory allocator on top of sbrk().
+
+   Small requests are rounded up to one of CLASS_CNT power-of-2
+   size classes, each of which has its own free list.  When a
+   class's list runs dry, a "run" of several blocks of that size
+   is carved out of a large block.  Freed small blocks go back on
+   their class's list and are never merged.
+
+   Larger requests are served first-fit from a list of free
+   blocks of any size, splitting off what is not needed.  Every
+   large block records its size at both ends, so that a freed
+   block can be merged with free neighbors on either side.
+
+   All memory comes from sbrk(), in pieces of at least
+   EXTEND_SIZE bytes.  Each contiguous piece of heap begins with
+   an in-use prologue block and ends with an in-use epilogue
+   header, so that merging never runs off either end.  Programs
+   that call sbrk() themselves just create a new piece. */
+
+/* Header at the start of every block. */
+struct header
+  {
+    size_t size;                /* Size of block, including overhead. */
+    size_t flags;               /* BLOCK_* flags. */
+  };
+
+#define BLOCK_LARGE 1           /* Large block, with a footer. */
+#define BLOCK_FREE 2            /* Free large block. */
+
+/* A free small block. */
+struct free_small
+  {
+    struct header header;
+    struct free_small *next;    /* Next free block of the same class. */
+  };
+
+/* A free large block. */
+struct free_large
+  {
+    struct header header;
+    struct free_large *prev;    /* Previous free large block. */
+    struct free_large *next;    /* Next free large block. */
+  };
+
+/* Size classes for small blocks are MIN_SMALL << 0 through
+   MIN_SMALL << (CLASS_CNT - 1) bytes, including the header. */
+#define MIN_SMALL 16
+#define CLASS_CNT 8
+#define MAX_SMALL (MIN_SMALL << (CLASS_CNT - 1))
+
+/* Overhead of a large block: the header and the footer, which is
+   the block's size in its last word. */
+#define LARGE_OVERHEAD (sizeof (struct header) + sizeof (size_t))
+
+/* Smallest large block, big enough to be put on the free list,
+   rounded up to keep blocks 8-byte aligned. */
+#define MIN_LARGE ROUND_UP (sizeof (struct free_large) + sizeof (size_t), 8)
+
+/* Size of the prologue block at the start of each piece. */
+#define PROLOGUE_SIZE ROUND_UP (LARGE_OVERHEAD, 8)
+
+/* Smallest amount by which to grow the heap. */
+#define EXTEND_SIZE (16 * 1024)
+
+/* Bytes of blocks in each run of small blocks. */
+#define RUN_SIZE 4096
+
+static struct free_small *small_free[CLASS_CNT];
+static struct free_large *large_free;
+static uint8_t *heap_end;       /* End of last piece of heap. */
+
+static void *large_alloc (size_t size);
+static void large_free_block (struct header *);
+
+/* Returns the size class for a small block of SIZE bytes,
+   including the header. */
+static int
+size_class (size_t size)
+{
+  int class = 0;
+  while ((size_t) MIN_SMALL << class < size)
+    class++;
+  return class;
+}
+
+/* Returns the block that follows H. */
+static struct header *
+next_block (struct header *h)
+{
+  return (struct header *) ((uint8_t *) h + h->size);
+}
+
+/* Returns the block that precedes H, found through its footer. */
+static struct header *
+prev_block (struct header *h)
+{
+  return (struct header *) ((uint8_t *) h - ((size_t *) h)[-1]);
+}
+
+/* Makes H a large block of SIZE bytes, free if FREE is true. */
+static void
+set_large (struct header *h, size_t size, bool free)
+{
+  h->size = size;
+  h->flags = BLOCK_LARGE | (free ? BLOCK_FREE : 0);
+  ((size_t *) next_block (h))[-1] = size;
+}
+
+/* Adds H, a free large block, to the free list. */
+static void
+push_large (struct header *h)
+{
+  struct free_large *f = (struct free_large *) h;
+  f->prev = NULL;
+  f->next = large_free;
+  if (large_free != NULL)
+    large_free->prev = f;
+  large_free = f;
+}
+
+/* Removes H, a free large block, from the free list. */
+static void
+remove_large (struct header *h)
+{
+  struct free_large *f = (struct free_large *) h;
+  if (f->prev != NULL)
+    f->prev->next = f->next;
+  else
+    large_free = f->next;
+  if (f->next != NULL)
+    f->next->prev = f->prev;
+}
+
+/* Obtains at least SIZE more bytes of large block from sbrk()
+   and adds them to the free list.  Returns false if SIZE is too
+   big to ask sbrk() for or if sbrk() fails. */
+static bool
+extend_heap (size_t size)
+{
+  size_t len;
+  uint8_t *p;
+  struct header *h, *epilogue;
+
+  /* Keep LEN from wrapping around or turning negative as an
+     sbrk() increment. */
+  if (size > INTPTR_MAX - PROLOGUE_SIZE - sizeof (struct header)
+             - EXTEND_SIZE)
+    return false;
+  len = ROUND_UP (size + PROLOGUE_SIZE + sizeof (struct header),
+                  EXTEND_SIZE);
+  p = sbrk (len);
+  if (p == (void *) -1)
+    return false;
+
+  if (p == heap_end)
+    {
+      /* The old epilogue becomes the new block's header. */
+      h = (struct header *) (p - sizeof *h);
+      set_large (h, len, true);
+    }
+  else
+    {
+      /* Start a new piece with a prologue. */
+      set_large ((struct header *) p, PROLOGUE_SIZE, false);
+      h = (struct header *) (p + PROLOGUE_SIZE);
+      set_large (h, len - PROLOGUE_SIZE - sizeof *h, true);
+    }
+  epilogue = next_block (h);
+  epilogue->size = 0;
+  epilogue->flags = BLOCK_LARGE;
+  heap_end = p + len;
+
+  large_free_block (h);
+  return true;
+}
+
+/* Allocates a large block with room for SIZE bytes of data and
+   returns the data, or a null pointer if memory is short. */
+static void *
+large_alloc (size_t size)
+{
+  struct free_large *f;
+  struct header *h;
+
+  if (size > SIZE_MAX - LARGE_OVERHEAD - 8)
+    return NULL;
+  size = ROUND_UP (size + LARGE_OVERHEAD, 8);
+  if (size < MIN_LARGE)
+    size = MIN_LARGE;
+
+  for (;;)
+    {
+      for (f = large_free; f != NULL; f = f->next)
+        if (f->header.size >= size)
+          break;
+      if (f != NULL)
+        break;
+      if (!extend_heap (size))
+        return NULL;
+    }
+
+  /* Split off the rest of the block if it's big enough to be
+     useful. */
+  h = &f->header;
+  remove_large (h);
+  if (h->size - size >= MIN_LARGE)
+    {
+      struct header *rest;
+      size_t rest_size = h->size - size;
+
+      set_large (h, size, false);
+      rest = next_block (h);
+      set_large (rest, rest_size, true);
+      push_large (rest);
+    }
+  else
+    set_large (h, h->size, false);
+  return h + 1;
+}
+
+/* Frees large block H, merging it with free neighbors. */
+static void
+large_free_block (struct header *h)
+{
+  struct header *next = next_block (h);
+  struct header *prev = prev_block (h);
+  size_t size = h->size;
+
+  if (next->flags & BLOCK_FREE)
+    {
+      remove_large (next);
+      size += next->size;
+    }
+  if (prev->flags & BLOCK_FREE)
+    {
+      remove_large (prev);
+      size += prev->size;
+      h = prev;
+    }
+  set_large (h, size, true);
+  push_large (h);
+}
+
+/* Obtains and returns a free block in size class CLASS, carving
+   a new run if necessary.  Returns a null pointer if memory is
+   short. */
+static struct free_small *
+small_alloc (int class)
+{
+  struct free_small *f = small_free[class];
+
+  if (f == NULL)
+    {
+      size_t size = MIN_SMALL << class;
+      size_t block_cnt = RUN_SIZE / size;
+      uint8_t *run;
+      size_t i;
+
+      if (block_cnt < 8)
+        block_cnt = 8;
+      run = large_alloc (block_cnt * size);
+      if (run == NULL)
+        return NULL;
+      for (i = 0; i < block_cnt; i++)
+        {
+          f = (struct free_small *) (run + i * size);
+          f->header.size = size;
+          f->header.flags = 0;
+          f->next = small_free[class];
+          small_free[class] = f;
+        }
+      f = small_free[class];
+    }
+  small_free[class] = f->next;
+  return f;
+}
+
+/* Obtains and returns a new block of at least SIZE bytes.
+   Returns a null pointer if memory is not available. */
+void *
+malloc (size_t size) 
+{
+  if (size == 0)
+    return NULL;
+  if (size <= MAX_SMALL - sizeof (struct header))
+    {
+      struct free_small *f;
+      f = small_alloc (size_class (size + sizeof (struct header)));
+      return f != NULL ? &f->header + 1 : NULL;
+    }
+  return large_alloc (size);
+}
+
+/* Allocates and return A times B bytes initialized to zeroes.
+   Returns a null pointer if memory is not available. */
+void *
+calloc (size_t a, size_t b) 
+{
+  void *p;
+  size_t size;
+
+  /* Calculate block size and make sure it fits in size_t. */
+  if (b != 0 && a > SIZE_MAX / b)
+    return NULL;
+  size = a * b;
+
+  /* Allocate and zero memory. */
+  p = malloc (size);
+  if (p != NULL)
+    memset (p, 0, size);
+
+  return p;
+}
+
+/* Returns the number of bytes of data that block B can hold. */
+static size_t
+block_size (void *b) 
+{
+  struct header *h = (struct header *) b - 1;
+  if (h->flags & BLOCK_LARGE)
+    return h->size - LARGE_OVERHEAD;
+  else
+    return h->size - sizeof *h;
+}
+
+/* Attempts to resize OLD_BLOCK to NEW_SIZE bytes, possibly
+   moving it in the process.
+   If successful, returns the new block; on failure, returns a
+   null pointer.
+   A call with null OLD_BLOCK is equivalent to malloc(NEW_SIZE).
+   A call with zero NEW_SIZE is equivalent to free(OLD_BLOCK). */
+void *
+realloc (void *old_block, size_t new_size) 
+{
+  if (new_size == 0) 
+    {
+      free (old_block);
+      return NULL;
+    }
+  else if (old_block == NULL)
+    return malloc (new_size);
+  else 
+    {
+      size_t old_size = block_size (old_block);
+      void *new_block;
+
+      if (new_size <= old_size)
+        return old_block;
+      new_block = malloc (new_size);
+      if (new_block != NULL) 
+        {
+          memcpy (new_block, old_block, old_size);
+          free (old_block);
+        }
+      return new_block;
+    }
+}
+
+/* Frees block P, which must have been previously allocated with
+   malloc(), calloc(), or realloc(). */
+void
+free (void *p) 
+{
+  struct header *h;
+
+  if (p == NULL)
+    return;
+
+  h = (struct header *) p - 1;
+  if (h->flags & BLOCK_LARGE)
+    {
+      ASSERT (!(h->flags & BLOCK_FREE));
+      large_free_block (h);
+    }
+  else
+    {
+      struct free_small *f = (struct free_small *) h;
+      int class = size_class (h->size);
+      f->next = small_free[class];
+      small_free[class] = f;
+    }
+}
@@ -1,9 +1,9 @@
 #include <syscall.h>
 #include "../syscall-nr.h"
 
-/* Invokes syscall NUMBER, passing no arguments, and returns the
-   return value as an `int'. */
-#define syscall0(NUMBER)                                        \
+/* Invokes syscall NUMBER with "int $0x30", passing no arguments,
+   and returns the return value as an `int'. */
+#define int_syscall0(NUMBER)                                    \
         ({                                                      \
           int retval;                                           \
           asm volatile                                          \
@@ -14,9 +14,9 @@
           retval;                                               \
         })
 
-/* Invokes syscall NUMBER, passing argument ARG0, and returns the
-   return value as an `int'. */
-#define syscall1(NUMBER, ARG0)                                           \
+/* Invokes syscall NUMBER with "int $0x30", passing argument
+   ARG0, and returns the return value as an `int'. */
+#define int_syscall1(NUMBER, ARG0)                                       \
         ({                                                               \
           int retval;                                                    \
           asm volatile                                                   \
@@ -28,9 +28,9 @@
           retval;                                                        \
         })
 
-/* Invokes syscall NUMBER, passing arguments ARG0 and ARG1, and
-   returns the return value as an `int'. */
-#define syscall2(NUMBER, ARG0, ARG1)                            \
+/* Invokes syscall NUMBER with "int $0x30", passing arguments
+   ARG0 and ARG1, and returns the return value as an `int'. */
+#define int_syscall2(NUMBER, ARG0, ARG1)                        \
         ({                                                      \
           int retval;                                           \
           asm volatile                                          \
@@ -44,9 +44,10 @@
           retval;                                               \
         })
 
-/* Invokes syscall NUMBER, passing arguments ARG0, ARG1, and
-   ARG2, and returns the return value as an `int'. */
-#define syscall3(NUMBER, ARG0, ARG1, ARG2)                      \
+/* Invokes syscall NUMBER with "int $0x30", passing arguments
+   ARG0, ARG1, and ARG2, and returns the return value as an
+   `int'. */
+#define int_syscall3(NUMBER, ARG0, ARG1, ARG2)                  \
         ({                                                      \
           int retval;                                           \
           asm volatile                                          \
@@ -61,6 +62,71 @@
           retval;                                               \
         })
 
+/* Invokes syscall NUMBER with SYSENTER, passing arguments ARG0,
+   ARG1, and ARG2, and returns the return value.  The kernel
+   ignores arguments beyond those that NUMBER takes.  SYSENTER
+   does not save the user stack pointer or return address, so we
+   pass them in %ecx and %edx for the kernel to return with. */
+static inline int
+sysenter_syscall (int number, int arg0, int arg1, int arg2)
+{
+  int retval;
+  asm volatile
+    ("pushl %[arg2]; pushl %[arg1]; pushl %[arg0]; pushl %%eax; "
+     "movl %%esp, %%ecx; movl $1f, %%edx; sysenter; "
+     "1: addl $16, %%esp"
+       : "=a" (retval)
+       : "0" (number),
+         [arg0] "r" (arg0),
+         [arg1] "r" (arg1),
+         [arg2] "r" (arg2)
+       : "ecx", "edx", "memory");
+  return retval;
+}
+
+/* Whether the kernel lets us use SYSENTER: 0 if not yet known, 1
+   if so, -1 if not. */
+static int sysenter_state;
+
+/* Returns true if system calls should be made with SYSENTER,
+   asking the kernel the first time. */
+static inline bool
+use_sysenter (void)
+{
+  if (sysenter_state == 0)
+    sysenter_state = int_syscall0 (SYS_SYSENTER) ? 1 : -1;
+  return sysenter_state > 0;
+}
+
+/* Invokes syscall NUMBER, passing no arguments, and returns the
+   return value as an `int'. */
+#define syscall0(NUMBER)                                        \
+        (use_sysenter ()                                        \
+         ? sysenter_syscall (NUMBER, 0, 0, 0)                   \
+         : int_syscall0 (NUMBER))
+
+/* Invokes syscall NUMBER, passing argument ARG0, and returns the
+   return value as an `int'. */
+#define syscall1(NUMBER, ARG0)                                  \
+        (use_sysenter ()                                        \
+         ? sysenter_syscall (NUMBER, (int) (ARG0), 0, 0)        \
+         : int_syscall1 (NUMBER, ARG0))
+
+/* Invokes syscall NUMBER, passing arguments ARG0 and ARG1, and
+   returns the return value as an `int'. */
+#define syscall2(NUMBER, ARG0, ARG1)                                    \
+        (use_sysenter ()                                                \
+         ? sysenter_syscall (NUMBER, (int) (ARG0), (int) (ARG1), 0)     \
+         : int_syscall2 (NUMBER, ARG0, ARG1))
+
+/* Invokes syscall NUMBER, passing arguments ARG0, ARG1, and
+   ARG2, and returns the return value as an `int'. */
+#define syscall3(NUMBER, ARG0, ARG1, ARG2)                              \
+        (use_sysenter ()                                                \
+         ? sysenter_syscall (NUMBER, (int) (ARG0), (int) (ARG1),        \
+                             (int) (ARG2))                              \
+         : int_syscall3 (NUMBER, ARG0, ARG1, ARG2))
+
 void
 halt (void) 
 {
@@ -182,3 +248,69 @@ inumber (int fd)
 {
   return syscall1 (SYS_INUMBER, fd);
 }
+
+bool
+getrusage (struct rusage *usage)
+{
+  return syscall1 (SYS_GETRUSAGE, usage);
+}
+
+bool
+madvise (void *addr, unsigned length, int advice)
+{
+  return syscall3 (SYS_MADVISE, addr, length, advice);
+}
+
+int
+readv (int fd, const struct iovec *iov, int iov_cnt)
+{
+  return syscall3 (SYS_READV, fd, iov, iov_cnt);
+}
+
+int
+writev (int fd, const struct iovec *iov, int iov_cnt)
+{
+  return syscall3 (SYS_WRITEV, fd, iov, iov_cnt);
+}
+
+int
+ring_enter (struct ring *ring)
+{
+  return syscall1 (SYS_RING_ENTER, ring);
+}
+
+int
+copy_file_range (int in_fd, int out_fd, unsigned length)
+{
+  return syscall3 (SYS_COPY_FILE_RANGE, in_fd, out_fd, length);
+}
+
+bool
+pipe (int fds[2])
+{
+  return syscall1 (SYS_PIPE, fds);
+}
+
+int
+dup2 (int old_fd, int new_fd)
+{
+  return syscall2 (SYS_DUP2, old_fd, new_fd);
+}
+
+bool
+gettime (uint64_t *ns)
+{
+  return syscall1 (SYS_GETTIME, ns);
+}
+
+void *
+sbrk (intptr_t increment)
+{
+  return (void *) syscall1 (SYS_SBRK, increment);
+}
+
+pid_t
+spawn (const char *file, const char *argv[], const int fd_map[])
+{
+  return syscall3 (SYS_SPAWN, file, argv, fd_map);
+}
@@ -2,7 +2,12 @@
 #define __LIB_USER_SYSCALL_H
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <debug.h>
+#include <iovec.h>
+#include <ring.h>
+#include <madvise.h>
+#include <rusage.h>
 
 /* Process identifier. */
 typedef int pid_t;
@@ -45,4 +50,17 @@ bool readdir (int fd, char name[READDIR_MAX_LEN + 1]);
 bool isdir (int fd);
 int inumber (int fd);
 
+/* Extensions. */
+bool getrusage (struct rusage *);
+bool madvise (void *addr, unsigned length, int advice);
+int readv (int fd, const struct iovec *, int iov_cnt);
+int writev (int fd, const struct iovec *, int iov_cnt);
+int ring_enter (struct ring *);
+int copy_file_range (int in_fd, int out_fd, unsigned length);
+bool pipe (int fds[2]);
+int dup2 (int old_fd, int new_fd);
+bool gettime (uint64_t *ns);
+void *sbrk (intptr_t increment);
+pid_t spawn (const char *file, const char *argv[], const int fd_map[]);
+
 #endif /* lib/user/syscall.h */
@@ -0,0 +1,74 @@
+#ifndef __LIB_VDSO_H
+#define __LIB_VDSO_H
+
+#include <stdint.h>
+
+/* The vDSO page: one page of kernel data that is mapped
+   read-only at VDSO_ADDR in every user process and updated on
+   every timer tick, so that reading the time takes no system
+   call.  The page begins with a struct vdso_data. */
+#define VDSO_ADDR ((void *) 0x08047000)
+
+/* TSC_MULT is nanoseconds per TSC cycle times 2**VDSO_SHIFT. */
+#define VDSO_SHIFT 24
+
+struct vdso_data
+  {
+    uint32_t seq;               /* Odd while being updated. */
+    uint32_t ns_per_tick;       /* Nanoseconds per timer tick. */
+    int64_t ticks;              /* Timer ticks since boot. */
+    uint64_t ns;                /* Nanoseconds since boot, at TICKS. */
+    uint64_t tsc;               /* Time-stamp counter, at TICKS. */
+    uint64_t tsc_freq;          /* TSC cycles per second, or 0. */
+    uint32_t tsc_mult;          /* Cycles to ns; 0 if no TSC. */
+  };
+
+/* Returns the nanoseconds since boot according to V, refined
+   with the time-stamp counter if it is usable.  V's writer
+   increments SEQ before and after each update, so a read that
+   sees an odd SEQ, or sees SEQ change, raced with an update and
+   is retried. */
+static inline uint64_t
+vdso_read_ns (const volatile struct vdso_data *v)
+{
+  uint32_t seq;
+  uint64_t ns;
+
+  do
+    {
+      seq = v->seq;
+      asm volatile ("" : : : "memory");
+      ns = v->ns;
+      if (v->tsc_mult != 0)
+        {
+          uint64_t tsc, ofs;
+          asm volatile ("rdtsc" : "=A" (tsc));
+          ofs = ((uint64_t) (uint32_t) (tsc - v->tsc) * v->tsc_mult
+                 >> VDSO_SHIFT);
+          ns += ofs < v->ns_per_tick ? ofs : v->ns_per_tick;
+        }
+      asm volatile ("" : : : "memory");
+    }
+  while ((seq & 1) != 0 || seq != v->seq);
+  return ns;
+}
+
+/* Returns the timer ticks since boot according to V. */
+static inline int64_t
+vdso_read_ticks (const volatile struct vdso_data *v)
+{
+  uint32_t seq;
+  int64_t ticks;
+
+  do
+    {
+      seq = v->seq;
+      asm volatile ("" : : : "memory");
+      ticks = v->ticks;
+      asm volatile ("" : : : "memory");
+    }
+  while ((seq & 1) != 0 || seq != v->seq);
+  return ticks;
+}
+
+#endif /* lib/vdso.h */
@@ -0,0 +1,24 @@
+/* Passes child-args a command line that spans more than one
+   page of the child's stack. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ARG_CNT 600
+
+static char cmd_line[ARG_CNT * 9 + 16];
+
+void
+test_main (void) 
+{
+  size_t ofs;
+  int i;
+
+  ofs = snprintf (cmd_line, sizeof cmd_line, "child-args");
+  for (i = 1; i <= ARG_CNT; i++)
+    ofs += snprintf (cmd_line + ofs, sizeof cmd_line - ofs, " %08d", i);
+  CHECK (wait (exec (cmd_line)) == 0, "exec child-args with %d arguments",
+         ARG_CNT);
+}
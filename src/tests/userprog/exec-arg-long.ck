@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+my ($args) = join ('', map (sprintf ("(args) argv[%d] = '%08d'\n", $_, $_),
+                            1...600));
+check_expected ([<<EOF]);
+(exec-arg-long) begin
+(exec-arg-long) exec child-args with 600 arguments
+(args) begin
+(args) argc = 601
+(args) argv[0] = 'child-args'
+$args(args) argv[601] = null
+(args) end
+child-args: exit(0)
+(exec-arg-long) end
+exec-arg-long: exit(0)
+EOF
+pass;
@@ -0,0 +1,19 @@
+/* Runs child-simple, overwrites the start of its ELF header, and
+   verifies that running it again fails instead of reusing the
+   headers read the first time. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  int handle;
+
+  CHECK (wait (exec ("child-simple")) == 81, "run child-simple");
+  CHECK ((handle = open ("child-simple")) > 1, "open \"child-simple\"");
+  CHECK (write (handle, "X", 1) == 1, "overwrite ELF magic");
+  close (handle);
+  msg ("exec(\"child-simple\"): %d", exec ("child-simple"));
+}
@@ -0,0 +1,30 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF', <<'EOF']);
+(exec-rewrite) begin
+(exec-rewrite) run child-simple
+(child-simple) run
+child-simple: exit(81)
+(exec-rewrite) open "child-simple"
+(exec-rewrite) overwrite ELF magic
+load: child-simple: error loading executable
+child-simple: exit(-1)
+(exec-rewrite) exec("child-simple"): -1
+(exec-rewrite) end
+exec-rewrite: exit(0)
+EOF
+(exec-rewrite) begin
+(exec-rewrite) run child-simple
+(child-simple) run
+child-simple: exit(81)
+(exec-rewrite) open "child-simple"
+(exec-rewrite) overwrite ELF magic
+load: child-simple: error loading executable
+(exec-rewrite) exec("child-simple"): -1
+child-simple: exit(-1)
+(exec-rewrite) end
+exec-rewrite: exit(0)
+EOF
+pass;
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(iov-normal) begin
+(iov-normal) create "test.txt"
+(iov-normal) open "test.txt"
+(iov-normal) contents match
+(iov-normal) readv() with bad count fails
+(iov-normal) end
+iov-normal: exit(0)
+EOF
+pass;
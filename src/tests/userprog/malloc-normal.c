@@ -0,0 +1,93 @@
+/* Allocates, reallocates, and frees blocks of many sizes with
+   malloc(), checking that they do not overlap, then grows and
+   shrinks the heap directly with sbrk(). */
+
+#include <malloc.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define BLOCK_CNT 64
+
+/* Lowest address of the stack region, which the heap may not
+   grow into: PHYS_BASE - STACK_MAX in the kernel. */
+#define STACK_BOTTOM ((char *) 0xbf800000)
+
+static char *blocks[BLOCK_CNT];
+static size_t sizes[BLOCK_CNT];
+
+/* Fails unless the first SIZE bytes of block I all equal I. */
+static void
+check_block (int i, size_t size) 
+{
+  size_t j;
+
+  for (j = 0; j < size; j++)
+    if (blocks[i][j] != (char) i)
+      fail ("block %d corrupted at byte %zu", i, j);
+}
+
+void
+test_main (void) 
+{
+  size_t gap;
+  char *p;
+  int i;
+
+  for (i = 0; i < BLOCK_CNT; i++)
+    {
+      sizes[i] = (i * 97) % 5000 + 1;
+      blocks[i] = malloc (sizes[i]);
+      if (blocks[i] == NULL)
+        fail ("malloc (%zu) failed", sizes[i]);
+      memset (blocks[i], i, sizes[i]);
+    }
+  for (i = 0; i < BLOCK_CNT; i++)
+    check_block (i, sizes[i]);
+  msg ("allocated %d blocks", BLOCK_CNT);
+
+  for (i = 0; i < BLOCK_CNT; i++)
+    if (i % 2)
+      free (blocks[i]);
+    else
+      {
+        blocks[i] = realloc (blocks[i], sizes[i] * 2);
+        if (blocks[i] == NULL)
+          fail ("realloc (%zu) failed", sizes[i] * 2);
+        check_block (i, sizes[i]);
+        memset (blocks[i], i, sizes[i] * 2);
+      }
+  for (i = 0; i < BLOCK_CNT; i += 2)
+    check_block (i, sizes[i] * 2);
+  msg ("reallocated even blocks");
+
+  for (i = 0; i < BLOCK_CNT; i += 2)
+    free (blocks[i]);
+
+  CHECK (malloc (SIZE_MAX - 64) == NULL, "huge malloc fails");
+  CHECK (calloc (0x10000, 0x10001) == NULL, "overflowing calloc fails");
+
+  CHECK ((p = sbrk (3 * 4096)) != (void *) -1, "grow heap");
+  memset (p, 0x5a, 3 * 4096);
+  CHECK (sbrk (-3 * 4096) == p + 3 * 4096, "shrink heap");
+  CHECK (sbrk (0) == p, "heap end restored");
+
+  /* Move the break to exactly the bottom of the stack region and
+     try to go one byte further.  A single increment cannot span
+     the gap, so take two steps.  Without virtual memory, heap
+     pages are allocated right away, so the first step fails for
+     lack of memory and only the final check applies. */
+  gap = STACK_BOTTOM - p;
+  if (sbrk (gap / 2) != (void *) -1)
+    {
+      if (sbrk (gap - gap / 2) == (void *) -1)
+        fail ("growing heap up to the stack region failed");
+      if (sbrk (1) != (void *) -1)
+        fail ("grew heap into the stack region");
+      if (sbrk (-(intptr_t) (gap - gap / 2)) == (void *) -1
+          || sbrk (-(intptr_t) (gap / 2)) == (void *) -1)
+        fail ("shrinking heap from the stack region failed");
+    }
+  CHECK (sbrk (0) == p, "growing into stack fails");
+}
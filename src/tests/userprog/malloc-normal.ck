@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(malloc-normal) begin
+(malloc-normal) allocated 64 blocks
+(malloc-normal) reallocated even blocks
+(malloc-normal) huge malloc fails
+(malloc-normal) overflowing calloc fails
+(malloc-normal) grow heap
+(malloc-normal) shrink heap
+(malloc-normal) heap end restored
+(malloc-normal) growing into stack fails
+(malloc-normal) end
+malloc-normal: exit(0)
+EOF
+pass;
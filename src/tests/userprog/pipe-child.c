@@ -0,0 +1,40 @@
+/* Creates a pipe, passes data through it, and then runs a child
+   process with its standard output redirected into the pipe and
+   reads back what the child printed. */
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  static const char data[] = "pipe data";
+  char buf[128];
+  int fds[2];
+  pid_t child;
+  int n;
+
+  CHECK (pipe (fds), "pipe");
+  CHECK (write (fds[1], data, sizeof data) == sizeof data, "write to pipe");
+  CHECK (read (fds[0], buf, sizeof buf) == sizeof data, "read from pipe");
+  if (strcmp (buf, data))
+    fail ("read \"%s\" instead of \"%s\"", buf, data);
+
+  /* Don't call msg() while standard output goes to the pipe. */
+  if (dup2 (fds[1], STDOUT_FILENO) != STDOUT_FILENO)
+    fail ("dup2 failed");
+  child = exec ("child-simple");
+  close (STDOUT_FILENO);
+  close (fds[1]);
+  msg ("wait(exec()) = %d", wait (child));
+
+  n = read (fds[0], buf, sizeof buf - 1);
+  CHECK (n > 0, "read child's output from pipe");
+  buf[n] = '\0';
+  if (strcmp (buf, "(child-simple) run\n"))
+    fail ("child wrote \"%s\" to pipe", buf);
+  CHECK (read (fds[0], buf, sizeof buf) == 0, "read end of file");
+}
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pipe-child) begin
+(pipe-child) pipe
+(pipe-child) write to pipe
+(pipe-child) read from pipe
+child-simple: exit(81)
+(pipe-child) wait(exec()) = 81
+(pipe-child) read child's output from pipe
+(pipe-child) read end of file
+(pipe-child) end
+pipe-child: exit(0)
+EOF
+pass;
@@ -0,0 +1,21 @@
+/* Creates a pipe as the process's first descriptors, then opens
+   a file, and checks that none of them takes the handle of the
+   standard input or output. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  int fds[2];
+  int handle;
+
+  CHECK (pipe (fds), "pipe");
+  if (fds[0] < 2 || fds[1] < 2)
+    fail ("pipe() returned handles %d and %d", fds[0], fds[1]);
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  if (handle == fds[0] || handle == fds[1])
+    fail ("open() returned pipe handle %d", handle);
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pipe-first) begin
+(pipe-first) pipe
+(pipe-first) open "sample.txt"
+(pipe-first) end
+pipe-first: exit(0)
+EOF
+pass;
@@ -0,0 +1,94 @@
+/* Copies a file with a linked read and write submitted through
+   ring_enter(), then checks that a request linked to a failed one
+   fails too, that an unknown operation fails, and that a full
+   completion queue stops the kernel from taking more requests. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static struct ring ring;
+
+/* Queues a request for OP with the given FLAGS, FD, BUF, and
+   SIZE, tagged with USER_DATA. */
+static void
+submit (int op, int flags, int fd, void *buf, unsigned size,
+        uint32_t user_data)
+{
+  struct ring_sqe *sqe = &ring.sq[ring.sq_tail++ % RING_ENTRIES];
+
+  sqe->op = op;
+  sqe->flags = flags;
+  sqe->fd = fd;
+  sqe->buf = buf;
+  sqe->size = size;
+  sqe->user_data = user_data;
+}
+
+/* Takes the next completion, which must carry USER_DATA, and
+   returns its result. */
+static int
+reap (uint32_t user_data)
+{
+  struct ring_cqe *cqe;
+
+  if (ring.cq_head == ring.cq_tail)
+    fail ("no completion for request %u", user_data);
+  cqe = &ring.cq[ring.cq_head++ % RING_ENTRIES];
+  if (cqe->user_data != user_data)
+    fail ("completion for request %u instead of %u",
+          cqe->user_data, user_data);
+  return cqe->result;
+}
+
+void
+test_main (void) 
+{
+  char buf[sizeof sample];
+  size_t size = sizeof sample - 1;
+  int in, out, byte_cnt;
+  int i;
+
+  CHECK (create ("test.txt", 0), "create \"test.txt\"");
+  CHECK ((in = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK ((out = open ("test.txt")) > 1, "open \"test.txt\"");
+
+  /* The write takes its size from the read. */
+  submit (RING_READ, 0, in, buf, sizeof buf, 1);
+  submit (RING_WRITE, RING_LINK, out, buf, 0, 2);
+  CHECK (ring_enter (&ring) == 2, "ring_enter() linked read and write");
+  if ((byte_cnt = reap (1)) != (int) size)
+    fail ("read returned %d instead of %zu", byte_cnt, size);
+  if ((byte_cnt = reap (2)) != (int) size)
+    fail ("write returned %d instead of %zu", byte_cnt, size);
+  seek (out, 0);
+  memset (buf, 0, sizeof buf);
+  if (read (out, buf, sizeof buf) != (int) size || memcmp (buf, sample, size))
+    fail ("\"test.txt\" differs from \"sample.txt\"");
+  msg ("contents match");
+
+  /* A failed request fails the request linked to it, and an
+     unknown operation fails. */
+  submit (RING_OPEN, 0, 0, "no-such-file", 0, 3);
+  submit (RING_READ, RING_LINK, in, buf, 0, 4);
+  submit (0xff, 0, 0, NULL, 0, 5);
+  CHECK (ring_enter (&ring) == 3, "ring_enter() failing requests");
+  CHECK (reap (3) == -1, "open of missing file fails");
+  CHECK (reap (4) == -1, "read linked to failed open fails");
+  CHECK (reap (5) == -1, "unknown operation fails");
+
+  /* With all but one completion left unconsumed, only one of
+     three requests runs. */
+  ring.cq_tail += RING_ENTRIES - 1;
+  for (i = 0; i < 3; i++)
+    submit (RING_SEEK, 0, in, NULL, 0, 6 + i);
+  CHECK (ring_enter (&ring) == 1, "ring_enter() with one free completion");
+  CHECK (ring.sq_tail - ring.sq_head == 2, "two requests left queued");
+  ring.cq_head += RING_ENTRIES - 1;
+  CHECK (reap (6) == 0, "seek completed");
+  CHECK (ring_enter (&ring) == 2, "ring_enter() drains the rest");
+  CHECK (ring.sq_head == ring.sq_tail, "submission queue empty");
+  CHECK (reap (7) == 0 && reap (8) == 0, "remaining seeks completed");
+}
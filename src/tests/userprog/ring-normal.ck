@@ -0,0 +1,25 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(ring-normal) begin
+(ring-normal) create "test.txt"
+(ring-normal) open "sample.txt"
+(ring-normal) open "test.txt"
+(ring-normal) ring_enter() linked read and write
+(ring-normal) contents match
+(ring-normal) ring_enter() failing requests
+(ring-normal) open of missing file fails
+(ring-normal) read linked to failed open fails
+(ring-normal) unknown operation fails
+(ring-normal) ring_enter() with one free completion
+(ring-normal) two requests left queued
+(ring-normal) seek completed
+(ring-normal) ring_enter() drains the rest
+(ring-normal) submission queue empty
+(ring-normal) remaining seeks completed
+(ring-normal) end
+ring-normal: exit(0)
+EOF
+pass;
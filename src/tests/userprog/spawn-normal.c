@@ -0,0 +1,40 @@
+/* Runs child processes with spawn(): one with an argument that
+   contains a space, one with its standard output mapped to the
+   write end of a pipe, and one that does not exist. */
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  const char *args_argv[] = {"child-args", "two words", NULL};
+  const char *simple_argv[] = {"child-simple", NULL};
+  int fd_map[3];
+  char buf[128];
+  int fds[2];
+  int n;
+
+  msg ("wait(spawn()) = %d", wait (spawn ("child-args", args_argv, NULL)));
+
+  CHECK (pipe (fds), "pipe");
+  fd_map[0] = STDIN_FILENO;
+  fd_map[1] = fds[1];
+  fd_map[2] = -1;
+  msg ("wait(spawn()) = %d",
+       wait (spawn ("child-simple", simple_argv, fd_map)));
+  close (fds[1]);
+
+  n = read (fds[0], buf, sizeof buf - 1);
+  CHECK (n > 0, "read child's output from pipe");
+  buf[n] = '\0';
+  if (strcmp (buf, "(child-simple) run\n"))
+    fail ("child wrote \"%s\" to pipe", buf);
+  CHECK (read (fds[0], buf, sizeof buf) == 0, "read end of file");
+
+  msg ("spawn(\"no-such-file\"): %d",
+       spawn ("no-such-file", simple_argv, NULL));
+}
@@ -0,0 +1,25 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(spawn-normal) begin
+(args) begin
+(args) argc = 2
+(args) argv[0] = 'child-args'
+(args) argv[1] = 'two words'
+(args) argv[2] = null
+(args) end
+child-args: exit(0)
+(spawn-normal) wait(spawn()) = 0
+(spawn-normal) pipe
+child-simple: exit(81)
+(spawn-normal) wait(spawn()) = 81
+(spawn-normal) read child's output from pipe
+(spawn-normal) read end of file
+load: no-such-file: open failed
+(spawn-normal) spawn("no-such-file"): -1
+(spawn-normal) end
+spawn-normal: exit(0)
+EOF
+pass;
@@ -0,0 +1,30 @@
+/* Reads the time from the vDSO page and checks it against the
+   gettime system call. */
+
+#include <clock.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  uint64_t before, ns, after;
+  int64_t ticks;
+
+  before = clock_ns ();
+  CHECK (gettime (&ns), "gettime");
+  after = clock_ns ();
+  if (before > ns || ns > after)
+    fail ("clock went backward: %llu, %llu, %llu",
+          (unsigned long long) before, (unsigned long long) ns,
+          (unsigned long long) after);
+
+  /* Wait for the tick count to advance. */
+  ticks = clock_ticks ();
+  while (clock_ticks () == ticks)
+    continue;
+  if (clock_ns () <= after)
+    fail ("clock did not advance with ticks");
+  msg ("clock advanced");
+}
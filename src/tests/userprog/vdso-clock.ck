@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(vdso-clock) begin
+(vdso-clock) gettime
+(vdso-clock) clock advanced
+(vdso-clock) end
+vdso-clock: exit(0)
+EOF
+pass;
@@ -0,0 +1,33 @@
+/* Checks that madvise() with MADV_DONTNEED discards the contents
+   of zero-fill pages, that the other kinds of advice are
+   accepted, and that bad arguments are rejected. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_CNT 16
+#define PAGE_SIZE 4096
+
+static char buf[PAGE_CNT * PAGE_SIZE] __attribute__ ((aligned (PAGE_SIZE)));
+
+void
+test_main (void)
+{
+  size_t i;
+
+  memset (buf, 0x5a, sizeof buf);
+  CHECK (madvise (buf, sizeof buf, MADV_SEQUENTIAL), "advise sequential");
+  CHECK (madvise (buf, sizeof buf, MADV_WILLNEED), "advise willneed");
+  CHECK (madvise (buf, sizeof buf, MADV_DONTNEED), "advise dontneed");
+  for (i = 0; i < sizeof buf; i++)
+    if (buf[i] != 0)
+      fail ("byte %zu is %d after MADV_DONTNEED", i, buf[i]);
+
+  CHECK (!madvise (buf + 1, PAGE_SIZE, MADV_NORMAL),
+         "reject misaligned address");
+  CHECK (!madvise (buf, sizeof buf, 42), "reject bad advice");
+  CHECK (!madvise ((void *) 0x10000000, PAGE_SIZE, MADV_WILLNEED),
+         "reject unmapped range");
+}
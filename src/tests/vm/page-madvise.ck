@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(page-madvise) begin
+(page-madvise) advise sequential
+(page-madvise) advise willneed
+(page-madvise) advise dontneed
+(page-madvise) reject misaligned address
+(page-madvise) reject bad advice
+(page-madvise) reject unmapped range
+(page-madvise) end
+EOF
+pass;
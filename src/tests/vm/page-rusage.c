@@ -0,0 +1,31 @@
+/* Writes to every page of a 64-page buffer and checks that
+   getrusage() accounts for the page faults this takes and for
+   the pages that became resident. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_CNT 64
+#define PAGE_SIZE 4096
+
+static char buf[PAGE_CNT * PAGE_SIZE];
+
+void
+test_main (void)
+{
+  struct rusage before, after;
+  size_t i;
+
+  CHECK (getrusage (&before), "getrusage before touching buffer");
+  for (i = 0; i < PAGE_CNT; i++)
+    buf[i * PAGE_SIZE] = i;
+  CHECK (getrusage (&after), "getrusage after touching buffer");
+
+  if (after.minor_faults + after.major_faults
+      <= before.minor_faults + before.major_faults)
+    fail ("no page faults counted");
+  if (after.resident_pages < before.resident_pages + PAGE_CNT)
+    fail ("only %u of %d pages counted as resident",
+          after.resident_pages - before.resident_pages, PAGE_CNT);
+}
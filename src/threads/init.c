@@ -28,6 +28,7 @@
 #include "userprog/gdt.h"
 #include "userprog/syscall.h"
 #include "userprog/tss.h"
+#include "userprog/vdso.h"
 #else
 #include "tests/threads/tests.h"
 #endif
@@ -37,6 +38,14 @@
 #include "filesys/filesys.h"
 #include "filesys/fsutil.h"
 #endif
+#ifdef VM
+#include "vm/frame.h"
+#include "vm/page.h"
+#include "vm/prefetch.h"
+#include "vm/share.h"
+#include "vm/swap.h"
+#include "vm/zswap.h"
+#endif
 
 /* Page directory with kernel mappings only. */
 uint32_t *init_page_dir;
@@ -100,6 +109,11 @@ pintos_init (void)
   palloc_init (user_page_limit);
   malloc_init ();
   paging_init ();
+#ifdef VM
+  frame_init ();
+  share_init ();
+  page_init ();
+#endif
 
   /* Segmentation. */
 #ifdef USERPROG
@@ -121,6 +135,10 @@ pintos_init (void)
   thread_start ();
   serial_init_queue ();
   timer_calibrate ();
+#ifdef USERPROG
+  vdso_init ();
+  process_init ();
+#endif
 
 #ifdef FILESYS
   /* Initialize file system. */
@@ -129,6 +147,12 @@ pintos_init (void)
   filesys_init (format_filesys);
 #endif
 
+#ifdef VM
+  swap_init ();
+  zswap_init ();
+  prefetch_init ();
+#endif
+
   printf ("Boot complete.\n");
   
   if (*argv != NULL) {
@@ -156,16 +180,49 @@ bss_init (void)
   memset (&_start_bss, 0, &_end_bss - &_start_bss);
 }
 
+/* CR4 flags.  See [IA32-v3a] 2.5 "Control Registers". */
+#define CR4_PSE 0x00000010      /* Page size extensions. */
+#define CR4_PGE 0x00000080      /* Page global enable. */
+
+/* Returns the CPUID function 1 feature flags in EDX. */
+uint32_t
+cpuid_features (void)
+{
+  uint32_t eax = 1, ebx, ecx, edx;
+  asm volatile ("cpuid" : "+a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx));
+  return edx;
+}
+
+/* Sets FLAGS in CR4. */
+static void
+cr4_set (uint32_t flags)
+{
+  uint32_t cr4;
+  asm volatile ("movl %%cr4, %0" : "=r" (cr4));
+  asm volatile ("movl %0, %%cr4" : : "r" (cr4 | flags) : "memory");
+}
+
 /* Populates the base page directory and page table with the
    kernel virtual mapping, and then sets up the CPU to use the
    new page directory.  Points init_page_dir to the page
-   directory it creates. */
+   directory it creates.
+
+   Where the CPU supports it, each 4 MB region of RAM is mapped
+   with a single 4 MB page, which takes one TLB entry instead of
+   1,024.  The region that holds the kernel's code still gets a
+   page table, so that the code can be mapped read-only, as does
+   any partial region at the end of RAM.  Kernel mappings are
+   also made global, so that their TLB entries survive the CR3
+   reload on every switch between processes. */
 static void
 paging_init (void)
 {
   uint32_t *pd, *pt;
   size_t page;
   extern char _start, _end_kernel_text;
+  uint32_t features = cpuid_features ();
+  bool large_pages = (features & CPUID_PSE) != 0;
+  const size_t pt_pages = PTSPAN / PGSIZE;
 
   pd = init_page_dir = palloc_get_page (PAL_ASSERT | PAL_ZERO);
   pt = NULL;
@@ -177,6 +234,14 @@ paging_init (void)
       size_t pte_idx = pt_no (vaddr);
       bool in_kernel_text = &_start <= vaddr && vaddr < &_end_kernel_text;
 
+      if (large_pages && pte_idx == 0 && page + pt_pages <= init_ram_pages
+          && !(vaddr < &_end_kernel_text && &_start < vaddr + PTSPAN))
+        {
+          pd[pde_idx] = pde_create_large_kernel (vaddr);
+          page += pt_pages - 1;
+          continue;
+        }
+
       if (pd[pde_idx] == 0)
         {
           pt = palloc_get_page (PAL_ASSERT | PAL_ZERO);
@@ -186,12 +251,21 @@ paging_init (void)
       pt[pte_idx] = pte_create_kernel (vaddr, !in_kernel_text);
     }
 
+  /* 4 MB pages must be enabled before a page directory that
+     uses them is loaded. */
+  if (large_pages)
+    cr4_set (CR4_PSE);
+
   /* Store the physical address of the page directory into CR3
      aka PDBR (page directory base register).  This activates our
      new page tables immediately.  See [IA32-v2a] "MOV--Move
      to/from Control Registers" and [IA32-v3a] 3.7.5 "Base Address
      of the Page Directory". */
   asm volatile ("movl %0, %%cr3" : : "r" (vtop (init_page_dir)));
+
+  /* Without global page support, PTE_G is simply ignored. */
+  if (features & CPUID_PGE)
+    cr4_set (CR4_PGE);
 }
 
 /* Breaks the kernel command line into words and returns them as
@@ -265,6 +339,14 @@ parse_options (char **argv)
 #ifdef USERPROG
       else if (!strcmp (name, "-ul"))
         user_page_limit = atoi (value);
+      else if (!strcmp (name, "-rusage"))
+        process_print_rusage = true;
+      else if (!strcmp (name, "-sysenter"))
+        syscall_use_sysenter = true;
+#endif
+#ifdef VM
+      else if (!strcmp (name, "-faultaround"))
+        page_fault_around = atoi (value);
 #endif
       else
         PANIC ("unknown option `%s' (use -h for help)", name);
@@ -387,6 +469,11 @@ usage (void)
           "  -mlfqs             Use multi-level feedback queue scheduler.\n"
 #ifdef USERPROG
           "  -ul=COUNT          Limit user memory to COUNT pages.\n"
+          "  -rusage            Print paging statistics on process exit.\n"
+          "  -sysenter          Let user programs enter the kernel with SYSENTER.\n"
+#endif
+#ifdef VM
+          "  -faultaround=N     Map N-page windows of file pages per fault.\n"
 #endif
           );
   shutdown_power_off ();
@@ -9,4 +9,13 @@
 /* Page directory with kernel mappings only. */
 extern uint32_t *init_page_dir;
 
+/* CPUID function 1 feature flags, in EDX.  See [IA32-v2a]
+   "CPUID--CPU Identification". */
+#define CPUID_PSE (1u << 3)     /* 4 MB pages. */
+#define CPUID_TSC (1u << 4)     /* Time-stamp counter. */
+#define CPUID_SEP (1u << 11)    /* SYSENTER and SYSEXIT. */
+#define CPUID_PGE (1u << 13)    /* Global pages. */
+
+uint32_t cpuid_features (void);
+
 #endif /* threads/init.h */
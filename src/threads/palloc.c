@@ -10,6 +10,9 @@
 #include "threads/loader.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
+#if defined USERPROG && !defined VM
+#include "userprog/process.h"
+#endif
 
 /* Page allocator.  Hands out memory in page-size (or
    page-multiple) chunks.  See malloc.h for an allocator that
@@ -81,6 +84,20 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt)
   page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
   lock_release (&pool->lock);
 
+#if defined USERPROG && !defined VM
+  /* Exited processes' user pages are freed along with their page
+     directories, which may be waiting for the reaper.  (With
+     virtual memory, they are freed at exit.)  Only for user
+     pages: kernel allocations may come from malloc() with a lock
+     held that reaping would need. */
+  if (page_idx == BITMAP_ERROR && (flags & PAL_USER) && process_reap ())
+    {
+      lock_acquire (&pool->lock);
+      page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
+      lock_release (&pool->lock);
+    }
+#endif
+
   if (page_idx != BITMAP_ERROR)
     pages = pool->base + PGSIZE * page_idx;
   else
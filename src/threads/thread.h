@@ -2,8 +2,11 @@
 #define THREADS_THREAD_H
 
 #include <debug.h>
+#include <hash.h>
 #include <list.h>
+#include <rusage.h>
 #include <stdint.h>
+#include "threads/synch.h"
 
 /* States in a thread's life cycle. */
 enum thread_status
@@ -98,6 +101,34 @@ struct thread
 #ifdef USERPROG
     /* Owned by userprog/process.c. */
     uint32_t *pagedir;                  /* Page directory. */
+    struct file *executable;            /* Executable, open while running. */
+    struct child *child;                /* Exit status shared with parent. */
+    struct list children;               /* Children's `struct child'. */
+    int exit_status;                    /* Status reported to parent. */
+    struct rusage rusage;               /* Paging statistics. */
+    uint8_t *heap_start;                /* Start of heap, page-aligned. */
+    uint8_t *heap_brk;                  /* End of heap. */
+
+    /* Owned by userprog/syscall.c. */
+    struct file_descriptor **fds;       /* Open files, indexed by handle. */
+    uint32_t *fd_map;                   /* Bitmap of handles in use. */
+    int fd_cnt;                         /* Number of slots in `fds'. */
+    void *user_esp;                     /* User %esp on syscall entry. */
+#endif
+
+#ifdef VM
+    /* Owned by vm/page.c. */
+    struct hash pages;                  /* Supplemental page table. */
+    struct lock page_lock;              /* Guards `pages' from prefetcher. */
+    uint8_t *fault_last;                /* Page of most recent fault. */
+    uint8_t *ra_next;                   /* First page past readahead. */
+    size_t ra_pages;                    /* Readahead window, in pages. */
+    int64_t ws_sampled;                 /* Ticks at last working set sample. */
+    unsigned ws_epoch;                  /* Number of samples taken. */
+
+    /* Owned by vm/mmap.c. */
+    struct list mappings;               /* Memory-mapped files. */
+    int next_mapid;                     /* Next mapping identifier. */
 #endif
 
     /* Owned by thread.c. */
@@ -2,8 +2,13 @@
 #include <inttypes.h>
 #include <stdio.h>
 #include "userprog/gdt.h"
+#include "userprog/uaccess.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "threads/vaddr.h"
+#ifdef VM
+#include "vm/page.h"
+#endif
 
 /* Number of page faults processed. */
 static long long page_fault_cnt;
@@ -148,9 +153,30 @@ page_fault (struct intr_frame *f)
   write = (f->error_code & PF_W) != 0;
   user = (f->error_code & PF_U) != 0;
 
-  /* To implement virtual memory, delete the rest of the function
-     body, and replace it with code that brings in the page to
-     which fault_addr refers. */
+#ifdef VM
+  /* Bring in the page that FAULT_ADDR refers to, if it belongs
+     to the process's address space or to its heap or stack, or
+     give it a frame of its own if it maps the zero page and this
+     is a write.  The kernel
+     faults on user pages too, when a system call touches a user
+     buffer that has not yet been paged in; the user stack pointer
+     is then the one saved on entry to the system call. */
+  if ((not_present || write) && is_user_vaddr (fault_addr)
+      && (page_in (fault_addr, write)
+          || (not_present
+              && (page_grow_heap (fault_addr, write)
+                  || page_grow_stack (fault_addr,
+                                      user ? f->esp
+                                      : thread_current ()->user_esp,
+                                      write)))))
+    return;
+#endif
+
+  /* A bad user address passed to a system call faults in one of
+     the user access routines, which recover from the fault. */
+  if (!user && uaccess_fixup (f))
+    return;
+
   printf ("Page fault at %p: %s error %s page in %s context.\n",
           fault_addr,
           not_present ? "not present" : "rights violation",
@@ -1,12 +1,29 @@
 #include "userprog/pagedir.h"
+#include <round.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <string.h>
 #include "threads/init.h"
+#include "threads/loader.h"
 #include "threads/pte.h"
 #include "threads/palloc.h"
 
+/* Each page directory keeps a bitmap of the user page tables it
+   has, so that pagedir_destroy() need look only at those.
+
+   The bitmap lives in the page directory entries at the very top
+   of the address space.  These are never present, because the
+   kernel maps at most 64 MB of RAM above PHYS_BASE, and the CPU
+   ignores everything but the present bit of a PDE that is not
+   present.  Each of these entries holds 31 bits of the bitmap,
+   in bits 1 through 31, leaving the present bit clear. */
+#define USER_PDES (LOADER_PHYS_BASE >> PDSHIFT)
+#define PT_MAP_BITS 31
+#define PT_MAP_WORDS DIV_ROUND_UP (USER_PDES, PT_MAP_BITS)
+#define PT_MAP_FIRST ((1u << PDBITS) - PT_MAP_WORDS)
+
 static uint32_t *active_pd (void);
+static void load_pagedir (uint32_t *);
 static void invalidate_pagedir (uint32_t *);
 
 /* Creates a new page directory that has mappings for kernel
@@ -17,6 +34,11 @@ uint32_t *
 pagedir_create (void) 
 {
   uint32_t *pd = palloc_get_page (0);
+
+  /* The kernel's mappings must leave room for the bitmap. */
+  ASSERT (pd_no (PHYS_BASE) + DIV_ROUND_UP (init_ram_pages, 1 << PTBITS)
+          <= PT_MAP_FIRST);
+
   if (pd != NULL)
     memcpy (pd, init_page_dir, PGSIZE);
   return pd;
@@ -27,23 +49,29 @@ pagedir_create (void)
 void
 pagedir_destroy (uint32_t *pd) 
 {
-  uint32_t *pde;
+  size_t i;
 
   if (pd == NULL)
     return;
 
   ASSERT (pd != init_page_dir);
-  for (pde = pd; pde < pd + pd_no (PHYS_BASE); pde++)
-    if (*pde & PTE_P) 
-      {
-        uint32_t *pt = pde_get_pt (*pde);
-        uint32_t *pte;
-        
-        for (pte = pt; pte < pt + PGSIZE / sizeof *pte; pte++)
-          if (*pte & PTE_P) 
-            palloc_free_page (pte_get_page (*pte));
-        palloc_free_page (pt);
-      }
+  for (i = 0; i < PT_MAP_WORDS; i++)
+    {
+      uint32_t bits = pd[PT_MAP_FIRST + i] >> 1;
+
+      while (bits != 0)
+        {
+          uint32_t *pt = pde_get_pt (pd[i * PT_MAP_BITS
+                                        + __builtin_ctz (bits)]);
+          uint32_t *pte;
+
+          for (pte = pt; pte < pt + PGSIZE / sizeof *pte; pte++)
+            if (*pte & PTE_P) 
+              palloc_free_page (pte_get_page (*pte));
+          palloc_free_page (pt);
+          bits &= bits - 1;
+        }
+    }
   palloc_free_page (pd);
 }
 
@@ -75,6 +103,8 @@ lookup_page (uint32_t *pd, const void *vaddr, bool create)
             return NULL; 
       
           *pde = pde_create (pt);
+          pd[PT_MAP_FIRST + pd_no (vaddr) / PT_MAP_BITS]
+            |= 2u << pd_no (vaddr) % PT_MAP_BITS;
         }
       else
         return NULL;
@@ -214,19 +244,50 @@ pagedir_set_accessed (uint32_t *pd, const void *vpage, bool accessed)
     }
 }
 
+/* Clears the accessed bit in the PTE for virtual page VPAGE in
+   PD and returns its previous value.  Unlike
+   pagedir_set_accessed(), does not flush the TLB, so that many
+   bits can be cleared at the cost of one flush: until the caller
+   calls pagedir_flush(), accesses through a stale TLB entry may
+   not set the bit again. */
+bool
+pagedir_test_and_clear_accessed (uint32_t *pd, const void *vpage) 
+{
+  uint32_t *pte = lookup_page (pd, vpage, false);
+  bool accessed = pte != NULL && (*pte & PTE_A) != 0;
+  if (accessed)
+    *pte &= ~(uint32_t) PTE_A;
+  return accessed;
+}
+
+/* Flushes the TLB if PD is the active page directory. */
+void
+pagedir_flush (uint32_t *pd) 
+{
+  invalidate_pagedir (pd);
+}
+
 /* Loads page directory PD into the CPU's page directory base
-   register. */
+   register, or the kernel-only page directory if PD is null.
+   Does nothing if PD is already loaded, because loading it again
+   would only flush the TLB. */
 void
 pagedir_activate (uint32_t *pd) 
 {
   if (pd == NULL)
     pd = init_page_dir;
+  if (pd != active_pd ())
+    load_pagedir (pd);
+}
 
-  /* Store the physical address of the page directory into CR3
-     aka PDBR (page directory base register).  This activates our
-     new page tables immediately.  See [IA32-v2a] "MOV--Move
-     to/from Control Registers" and [IA32-v3a] 3.7.5 "Base
-     Address of the Page Directory". */
+/* Stores the physical address of page directory PD into CR3
+   aka PDBR (page directory base register).  This activates PD
+   immediately and flushes all of the non-global entries from the
+   TLB.  See [IA32-v2a] "MOV--Move to/from Control Registers" and
+   [IA32-v3a] 3.7.5 "Base Address of the Page Directory". */
+static void
+load_pagedir (uint32_t *pd) 
+{
   asm volatile ("movl %0, %%cr3" : : "r" (vtop (pd)) : "memory");
 }
 
@@ -256,8 +317,8 @@ invalidate_pagedir (uint32_t *pd)
 {
   if (active_pd () == pd) 
     {
-      /* Re-activating PD clears the TLB.  See [IA32-v3a] 3.12
+      /* Re-loading PD clears the TLB.  See [IA32-v3a] 3.12
          "Translation Lookaside Buffers (TLBs)". */
-      pagedir_activate (pd);
+      load_pagedir (pd);
     } 
 }
@@ -0,0 +1,155 @@
+#include "userprog/pipe.h"
+#include <debug.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* A pipe: a page-sized ring buffer with a read end and a write
+   end, each of which may be open in any number of file
+   descriptors, possibly in different processes. */
+struct pipe
+  {
+    struct lock lock;           /* Protects all the members below. */
+    struct condition not_empty; /* Signaled when data is written. */
+    struct condition not_full;  /* Signaled when data is read. */
+    uint8_t *buf;               /* PGSIZE bytes of buffer. */
+    size_t head;                /* Total bytes ever read. */
+    size_t tail;                /* Total bytes ever written. */
+    int readers;                /* Number of open read ends. */
+    int writers;                /* Number of open write ends. */
+  };
+
+/* Creates and returns a new pipe with its read end and its write
+   end each open once, or a null pointer if memory is short. */
+struct pipe *
+pipe_create (void)
+{
+  struct pipe *p = malloc (sizeof *p);
+  if (p == NULL)
+    return NULL;
+
+  p->buf = palloc_get_page (0);
+  if (p->buf == NULL)
+    {
+      free (p);
+      return NULL;
+    }
+  lock_init (&p->lock);
+  cond_init (&p->not_empty);
+  cond_init (&p->not_full);
+  p->head = p->tail = 0;
+  p->readers = p->writers = 1;
+  return p;
+}
+
+/* Opens another reference to the write end of P if WRITER is
+   true, or to its read end otherwise. */
+void
+pipe_open (struct pipe *p, bool writer)
+{
+  lock_acquire (&p->lock);
+  if (writer)
+    p->writers++;
+  else
+    p->readers++;
+  lock_release (&p->lock);
+}
+
+/* Closes a reference to the write end of P if WRITER is true, or
+   to its read end otherwise.  Frees P once both ends are fully
+   closed. */
+void
+pipe_close (struct pipe *p, bool writer)
+{
+  bool dead;
+
+  lock_acquire (&p->lock);
+  if (writer)
+    {
+      ASSERT (p->writers > 0);
+      if (--p->writers == 0)
+        cond_broadcast (&p->not_empty, &p->lock);
+    }
+  else
+    {
+      ASSERT (p->readers > 0);
+      if (--p->readers == 0)
+        cond_broadcast (&p->not_full, &p->lock);
+    }
+  dead = p->readers == 0 && p->writers == 0;
+  lock_release (&p->lock);
+
+  if (dead)
+    {
+      palloc_free_page (p->buf);
+      free (p);
+    }
+}
+
+/* Reads up to SIZE bytes from P into BUF, waiting until at least
+   one byte is available or the write end is fully closed.
+   Returns the number of bytes read, which is 0 only at end of
+   file. */
+int
+pipe_read (struct pipe *p, void *buf_, size_t size)
+{
+  uint8_t *buf = buf_;
+  size_t cnt = 0;
+
+  lock_acquire (&p->lock);
+  while (p->head == p->tail && p->writers > 0 && size > 0)
+    cond_wait (&p->not_empty, &p->lock);
+  while (cnt < size && p->head != p->tail)
+    {
+      size_t ofs = p->head % PGSIZE;
+      size_t chunk = p->tail - p->head;
+      if (chunk > PGSIZE - ofs)
+        chunk = PGSIZE - ofs;
+      if (chunk > size - cnt)
+        chunk = size - cnt;
+      memcpy (buf + cnt, p->buf + ofs, chunk);
+      p->head += chunk;
+      cnt += chunk;
+    }
+  if (cnt > 0)
+    cond_broadcast (&p->not_full, &p->lock);
+  lock_release (&p->lock);
+
+  return cnt;
+}
+
+/* Writes SIZE bytes from BUF to P, waiting for room as needed.
+   Returns the number of bytes written, which is less than SIZE
+   only if the read end is fully closed, or -1 if it was closed
+   before anything was written. */
+int
+pipe_write (struct pipe *p, const void *buf_, size_t size)
+{
+  const uint8_t *buf = buf_;
+  size_t cnt = 0;
+
+  lock_acquire (&p->lock);
+  while (cnt < size && p->readers > 0)
+    {
+      size_t ofs = p->tail % PGSIZE;
+      size_t chunk = PGSIZE - (p->tail - p->head);
+      if (chunk == 0)
+        {
+          cond_wait (&p->not_full, &p->lock);
+          continue;
+        }
+      if (chunk > PGSIZE - ofs)
+        chunk = PGSIZE - ofs;
+      if (chunk > size - cnt)
+        chunk = size - cnt;
+      memcpy (p->buf + ofs, buf + cnt, chunk);
+      p->tail += chunk;
+      cnt += chunk;
+      cond_broadcast (&p->not_empty, &p->lock);
+    }
+  lock_release (&p->lock);
+
+  return cnt > 0 || size == 0 ? (int) cnt : -1;
+}
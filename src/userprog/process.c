@@ -7,62 +7,210 @@
 #include <string.h>
 #include "userprog/gdt.h"
 #include "userprog/pagedir.h"
+#include "userprog/syscall.h"
 #include "userprog/tss.h"
+#include "userprog/vdso.h"
 #include "filesys/directory.h"
 #include "filesys/file.h"
 #include "filesys/filesys.h"
+#include "filesys/inode.h"
 #include "threads/flags.h"
 #include "threads/init.h"
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
 #include "threads/palloc.h"
 #include "threads/thread.h"
 #include "threads/vaddr.h"
+#ifdef VM
+#include "vm/mmap.h"
+#include "vm/page.h"
+#include "vm/prefetch.h"
+#endif
+
+/* If true, print each process's paging statistics when it
+   exits, set with -rusage. */
+bool process_print_rusage;
+
+/* A page directory of an exited process, waiting for the
+   reaper thread to destroy it. */
+struct reap
+  {
+    uint32_t *pd;               /* Page directory. */
+    struct list_elem elem;      /* `reap_list' element. */
+  };
+
+static struct list reap_list;   /* Page directories to destroy. */
+static struct lock reap_lock;   /* Protects `reap_list'. */
+static struct semaphore reap_sema;  /* Upped when one is added. */
 
 static thread_func start_process NO_RETURN;
-static bool load (const char *cmdline, void (**eip) (void), void **esp);
+static thread_func reaper NO_RETURN;
+struct exec_info;
+static tid_t start_child (const char *name, struct exec_info *);
+static struct file *open_executable (const char *file_name);
+static bool load (const struct exec_info *, void (**eip) (void), void **esp);
+static bool add_zero_page (void *upage);
+static void remove_zero_page (void *upage);
+static void release_child (struct child *);
+
+/* Data passed from process_execute() or process_spawn() to
+   start_process().  The arguments come either from CMD_LINE or
+   from ARGS. */
+struct exec_info
+  {
+    const char *cmd_line;       /* Command line to execute, or null. */
+    const char *args;           /* ARGC packed strings, or null. */
+    size_t args_size;           /* Bytes in ARGS. */
+    int argc;                   /* Number of strings in ARGS. */
+    struct file *file;          /* Executable, if already open. */
+    const int *fd_map;          /* Handles to pass, or null. */
+    int fd_cnt;                 /* Number of handles in FD_MAP. */
+    struct thread *parent;      /* Thread starting the process. */
+    struct semaphore loaded;    /* Upped when loading is finished. */
+    bool success;               /* Did the program load successfully? */
+    struct child *child;        /* Child's status, if successful. */
+  };
 
-/* Starts a new thread running a user program loaded from
-   FILENAME.  The new thread may be scheduled (and may even exit)
-   before process_execute() returns.  Returns the new process's
-   thread id, or TID_ERROR if the thread cannot be created. */
+/* Starts the reaper thread, which frees the page directories of
+   exited processes, and with them all the page tables and, with
+   no virtual memory, all the user pages they map.  Doing this
+   in the background lets an exiting process get out of the way
+   of its parent sooner.  The reaper runs at the same priority as
+   user processes, so that busy processes cannot starve it while
+   the memory it would free runs out. */
+void
+process_init (void)
+{
+  list_init (&reap_list);
+  lock_init (&reap_lock);
+  sema_init (&reap_sema, 0);
+  thread_create ("reaper", PRI_DEFAULT, reaper, NULL);
+}
+
+/* Starts a new thread running a user program loaded from the
+   first word of CMD_LINE, passing it the remaining words as
+   arguments.  Waits for the program to be loaded.  Returns the
+   new process's thread id, or TID_ERROR if the thread cannot be
+   created or the program cannot be loaded.
+
+   The new process reads CMD_LINE in place while it loads, which
+   is safe because we wait for it to finish. */
 tid_t
-process_execute (const char *file_name) 
+process_execute (const char *cmd_line) 
 {
-  char *fn_copy;
-  tid_t tid;
+  struct exec_info exec;
+  char thread_name[16];
+  char *save_ptr;
+
+  exec.cmd_line = cmd_line;
+  exec.args = NULL;
+  exec.file = NULL;
+  exec.fd_map = NULL;
 
-  /* Make a copy of FILE_NAME.
-     Otherwise there's a race between the caller and load(). */
-  fn_copy = palloc_get_page (0);
-  if (fn_copy == NULL)
+  /* Name the thread after the program. */
+  strlcpy (thread_name, cmd_line, sizeof thread_name);
+  strtok_r (thread_name, " ", &save_ptr);
+
+  return start_child (thread_name, &exec);
+}
+
+/* Starts a new thread running the user program in FILE_NAME,
+   passing it the ARGC null-terminated strings packed into the
+   ARGS_SIZE bytes at ARGS as arguments.  Unlike
+   process_execute(), opens the executable and verifies its
+   headers right here, so that a missing or invalid program fails
+   without creating a thread.  If FD_MAP is non-null, the new
+   process's handle I, for each I < FD_CNT, is a copy of our
+   handle FD_MAP[I]; otherwise, handles are inherited as by
+   process_execute().  Waits for the program to be loaded.
+   Returns the new process's thread id, or TID_ERROR on
+   failure. */
+tid_t
+process_spawn (const char *file_name, const char *args, size_t args_size,
+               int argc, const int *fd_map, int fd_cnt)
+{
+  struct exec_info exec;
+
+  exec.file = open_executable (file_name);
+  if (exec.file == NULL)
     return TID_ERROR;
-  strlcpy (fn_copy, file_name, PGSIZE);
+  exec.cmd_line = NULL;
+  exec.args = args;
+  exec.args_size = args_size;
+  exec.argc = argc;
+  exec.fd_map = fd_map;
+  exec.fd_cnt = fd_cnt;
+  return start_child (file_name, &exec);
+}
 
-  /* Create a new thread to execute FILE_NAME. */
-  tid = thread_create (file_name, PRI_DEFAULT, start_process, fn_copy);
+/* Creates a thread named NAME to run the process described by
+   EXEC and waits for it to be loaded.  Returns the new process's
+   thread id, or TID_ERROR if the thread cannot be created or the
+   program cannot be loaded. */
+static tid_t
+start_child (const char *name, struct exec_info *exec)
+{
+  tid_t tid;
+
+  sema_init (&exec->loaded, 0);
+  exec->parent = thread_current ();
+  tid = thread_create (name, PRI_DEFAULT, start_process, exec);
   if (tid == TID_ERROR)
-    palloc_free_page (fn_copy); 
+    {
+      /* The new process would have closed it. */
+      lock_acquire (&filesys_lock);
+      file_close (exec->file);
+      lock_release (&filesys_lock);
+      return TID_ERROR;
+    }
+
+  sema_down (&exec->loaded);
+  if (!exec->success)
+    return TID_ERROR;
+  list_push_back (&thread_current ()->children, &exec->child->elem);
   return tid;
 }
 
 /* A thread function that loads a user process and starts it
    running. */
 static void
-start_process (void *file_name_)
+start_process (void *exec_)
 {
-  char *file_name = file_name_;
+  struct exec_info *exec = exec_;
+  struct thread *t = thread_current ();
   struct intr_frame if_;
   bool success;
 
+  /* The executable, if our parent opened it, is ours to close. */
+  t->executable = exec->file;
+
+  /* Allocate the status shared with our parent. */
+  t->child = malloc (sizeof *t->child);
+  if (t->child != NULL)
+    {
+      t->child->tid = t->tid;
+      t->child->exit_status = -1;
+      sema_init (&t->child->dead, 0);
+      lock_init (&t->child->ref_lock);
+      t->child->ref_cnt = 2;
+    }
+
   /* Initialize interrupt frame and load executable. */
   memset (&if_, 0, sizeof if_);
   if_.gs = if_.fs = if_.es = if_.ds = if_.ss = SEL_UDSEG;
   if_.cs = SEL_UCSEG;
   if_.eflags = FLAG_IF | FLAG_MBS;
-  success = load (file_name, &if_.eip, &if_.esp);
+  success = (t->child != NULL
+             && syscall_inherit (exec->parent, exec->fd_map, exec->fd_cnt)
+             && load (exec, &if_.eip, &if_.esp));
+
+  /* Notify our parent.  EXEC lives on the parent's stack, so we
+     may not touch it after this. */
+  exec->success = success;
+  exec->child = t->child;
+  sema_up (&exec->loaded);
 
   /* If load failed, quit. */
-  palloc_free_page (file_name);
   if (!success) 
     thread_exit ();
 
@@ -81,13 +229,28 @@ start_process (void *file_name_)
    exception), returns -1.  If TID is invalid or if it was not a
    child of the calling process, or if process_wait() has already
    been successfully called for the given TID, returns -1
-   immediately, without waiting.
-
-   This function will be implemented in problem 2-2.  For now, it
-   does nothing. */
+   immediately, without waiting. */
 int
-process_wait (tid_t child_tid UNUSED) 
+process_wait (tid_t child_tid) 
 {
+  struct thread *cur = thread_current ();
+  struct list_elem *e;
+
+  for (e = list_begin (&cur->children); e != list_end (&cur->children);
+       e = list_next (e)) 
+    {
+      struct child *c = list_entry (e, struct child, elem);
+      if (c->tid == child_tid) 
+        {
+          int exit_status;
+
+          list_remove (e);
+          sema_down (&c->dead);
+          exit_status = c->exit_status;
+          release_child (c);
+          return exit_status;
+        }
+    }
   return -1;
 }
 
@@ -96,8 +259,43 @@ void
 process_exit (void)
 {
   struct thread *cur = thread_current ();
+  struct list_elem *e, *next;
+  struct reap *r;
   uint32_t *pd;
 
+  /* Print our exit status, if we are a user process.  Our parent
+     hears of it only after teardown, below. */
+  if (cur->child != NULL) 
+    {
+      printf ("%s: exit(%d)\n", cur->name, cur->exit_status);
+      if (process_print_rusage)
+        {
+          const struct rusage *u = &cur->rusage;
+          printf ("%s: %u minor faults, %u major faults, %u evictions, "
+                  "%u swap-ins, %u resident pages, working set %u pages\n",
+                  cur->name, u->minor_faults, u->major_faults, u->evictions,
+                  u->swap_ins, u->resident_pages, u->working_set);
+        }
+    }
+
+  /* Our children no longer have a parent to report to. */
+  for (e = list_begin (&cur->children); e != list_end (&cur->children);
+       e = next) 
+    {
+      struct child *c = list_entry (e, struct child, elem);
+      next = list_remove (e);
+      release_child (c);
+    }
+
+  /* Close our open files. */
+  syscall_exit ();
+
+#ifdef VM
+  /* Stop the prefetch thread from loading any more pages into
+     our address space. */
+  prefetch_cancel (cur);
+#endif
+
   /* Destroy the current process's page directory and switch back
      to the kernel-only page directory. */
   pd = cur->pagedir;
@@ -112,8 +310,102 @@ process_exit (void)
          that's been freed (and cleared). */
       cur->pagedir = NULL;
       pagedir_activate (NULL);
-      pagedir_destroy (pd);
+#ifdef VM
+      page_table_destroy (&cur->pages, pd);
+      mmap_destroy ();
+#endif
+      vdso_unmap (pd);
+
+      /* Leave the page directory for the reaper thread, unless
+         there is not even memory to queue it. */
+      r = malloc (sizeof *r);
+      if (r != NULL)
+        {
+          r->pd = pd;
+          lock_acquire (&reap_lock);
+          list_push_back (&reap_list, &r->elem);
+          lock_release (&reap_lock);
+          sema_up (&reap_sema);
+        }
+      else
+        pagedir_destroy (pd);
     }
+
+  /* Close the executable only after its pages are gone, since
+     they may still have been reading from it. */
+  lock_acquire (&filesys_lock);
+  file_close (cur->executable);
+  lock_release (&filesys_lock);
+  cur->executable = NULL;
+
+  /* Report our exit status to our parent only now that our files
+     and pipe ends are closed and our mapped pages written back,
+     so that a parent returning from wait() sees all of it. */
+  if (cur->child != NULL)
+    {
+      cur->child->exit_status = cur->exit_status;
+      sema_up (&cur->child->dead);
+      release_child (cur->child);
+    }
+}
+
+/* Destroys all the page directories waiting for the reaper
+   thread, in one batch.  Returns true if there were any.  Also
+   called when memory runs out, so that a process that needs it
+   does not have to wait for the reaper: by load() when it cannot
+   create a page directory, since page tables come from the
+   kernel pool, and, without virtual memory, by the page
+   allocator when it runs out of user pages, since those are
+   then freed along with the page directory.  With virtual
+   memory, user pages are freed at exit instead. */
+bool
+process_reap (void)
+{
+  struct list batch;
+
+  list_init (&batch);
+  lock_acquire (&reap_lock);
+  if (!list_empty (&reap_list))
+    list_splice (list_end (&batch), list_begin (&reap_list),
+                 list_end (&reap_list));
+  lock_release (&reap_lock);
+
+  if (list_empty (&batch))
+    return false;
+  while (!list_empty (&batch))
+    {
+      struct reap *r = list_entry (list_pop_front (&batch),
+                                   struct reap, elem);
+      pagedir_destroy (r->pd);
+      free (r);
+    }
+  return true;
+}
+
+/* The reaper thread. */
+static void
+reaper (void *aux UNUSED)
+{
+  for (;;)
+    {
+      sema_down (&reap_sema);
+      process_reap ();
+    }
+}
+
+/* Drops a reference to C, freeing it if neither the parent nor
+   the child still refers to it. */
+static void
+release_child (struct child *c) 
+{
+  int ref_cnt;
+
+  lock_acquire (&c->ref_lock);
+  ref_cnt = --c->ref_cnt;
+  lock_release (&c->ref_lock);
+
+  if (ref_cnt == 0)
+    free (c);
 }
 
 /* Sets up the CPU for running user code in the current
@@ -124,8 +416,13 @@ process_activate (void)
 {
   struct thread *t = thread_current ();
 
-  /* Activate thread's page tables. */
-  pagedir_activate (t->pagedir);
+  /* Activate thread's page tables.  A kernel thread has none of
+     its own.  Every page directory maps the kernel the same way,
+     so it simply borrows whichever one is loaded, sparing a TLB
+     flush on switches between kernel threads and back to the
+     same process. */
+  if (t->pagedir != NULL)
+    pagedir_activate (t->pagedir);
 
   /* Set thread's kernel stack for use in processing
      interrupts. */
@@ -195,52 +492,206 @@ struct Elf32_Phdr
 #define PF_W 2          /* Writable. */
 #define PF_R 4          /* Readable. */
 
-static bool setup_stack (void **esp);
+/* A loadable segment of an executable, from a PT_LOAD program
+   header. */
+struct exec_segment
+  {
+    uint32_t file_page;         /* Page-aligned offset in file. */
+    uint32_t mem_page;          /* Page-aligned user virtual address. */
+    uint32_t read_bytes;        /* Bytes to read from the file. */
+    uint32_t zero_bytes;        /* Bytes to zero after those. */
+    bool writable;              /* Writable by the user process? */
+  };
+
+/* The validated ELF headers of an executable. */
+struct exec_image
+  {
+    struct inode *inode;        /* Executable, held open; null if free. */
+    unsigned generation;        /* INODE's generation when read. */
+    unsigned last_used;         /* `exec_clock' at last use. */
+    Elf32_Addr entry;           /* Entry point. */
+    uint32_t end;               /* End of highest segment. */
+    struct exec_segment *segments;  /* Loadable segments. */
+    int segment_cnt;            /* Number of SEGMENTS. */
+  };
+
+/* Exec cache.
+
+   Running a program means reading and checking its ELF header
+   and program headers, and the same few programs tend to be run
+   over and over, so we keep the results for the executables
+   used most recently.  An entry is keyed by inode number and
+   generation, so a write to the file makes it miss.  Each entry
+   holds its inode open, which keeps the inode number from being
+   reused for another file, but also keeps a removed executable's
+   blocks allocated until its entry is evicted.  Protected by
+   filesys_lock. */
+#define EXEC_CACHE_CNT 8
+static struct exec_image exec_cache[EXEC_CACHE_CNT];
+static unsigned exec_clock;     /* Incremented on every lookup. */
+
+static bool setup_stack (const struct exec_info *, void **esp);
+static struct exec_image *exec_cache_get (struct file *);
 static bool validate_segment (const struct Elf32_Phdr *, struct file *);
 static bool load_segment (struct file *file, off_t ofs, uint8_t *upage,
                           uint32_t read_bytes, uint32_t zero_bytes,
                           bool writable);
 
-/* Loads an ELF executable from FILE_NAME into the current thread.
-   Stores the executable's entry point into *EIP
-   and its initial stack pointer into *ESP.
-   Returns true if successful, false otherwise. */
-bool
-load (const char *file_name, void (**eip) (void), void **esp) 
+/* Loads the ELF executable described by EXEC, which is named by
+   the first word of its command line if it is not open already,
+   into the current thread and sets up its stack to pass it its
+   arguments.  Stores the executable's entry point into *EIP and
+   its initial stack pointer into *ESP.  Returns true if
+   successful, false otherwise. */
+static bool
+load (const struct exec_info *exec, void (**eip) (void), void **esp) 
 {
   struct thread *t = thread_current ();
-  struct Elf32_Ehdr ehdr;
-  struct file *file = NULL;
-  off_t file_ofs;
+  struct exec_image *image;
+  struct file *file = exec->file;
+  Elf32_Addr entry;
+  uint32_t end;
   bool success = false;
   int i;
 
-  /* Allocate and activate page directory. */
+  /* Allocate and activate page directory.  Exited processes'
+     page directories may be holding the memory we need. */
   t->pagedir = pagedir_create ();
-  if (t->pagedir == NULL) 
+  if (t->pagedir == NULL && process_reap ())
+    t->pagedir = pagedir_create ();
+  if (t->pagedir == NULL || !vdso_map (t->pagedir)) 
     goto done;
+#ifdef VM
+  page_table_init (&t->pages);
+#endif
   process_activate ();
 
-  /* Open executable file. */
+  /* Open executable file, unless process_spawn() already did. */
+  if (file == NULL)
+    {
+      char file_name[NAME_MAX + 1];
+      char *save_ptr;
+
+      strlcpy (file_name, exec->cmd_line, sizeof file_name);
+      strtok_r (file_name, " ", &save_ptr);
+      file = open_executable (file_name);
+      if (file == NULL)
+        goto done;
+    }
+
+  /* Set up the executable's segments.  Its headers were verified
+     when it was opened, so they are normally in the exec cache
+     now. */
+  lock_acquire (&filesys_lock);
+  image = exec_cache_get (file);
+  if (image == NULL)
+    goto done;
+  for (i = 0; i < image->segment_cnt; i++)
+    {
+      const struct exec_segment *s = &image->segments[i];
+      if (!load_segment (file, s->file_page, (void *) s->mem_page,
+                         s->read_bytes, s->zero_bytes, s->writable))
+        goto done;
+    }
+  entry = image->entry;
+  end = image->end;
+
+  lock_release (&filesys_lock);
+
+  /* The heap starts out empty, on the page after the last
+     segment. */
+  t->heap_start = t->heap_brk = pg_round_up ((void *) end);
+
+  /* Set up stack. */
+  if (!setup_stack (exec, esp))
+    goto done;
+
+  /* Start address. */
+  *eip = (void (*) (void)) entry;
+
+  success = true;
+
+ done:
+  /* We arrive here whether the load is successful or not.
+     Keep the executable open while the process runs, since its
+     pages are read from it on demand; process_exit() closes it. */
+  if (lock_held_by_current_thread (&filesys_lock))
+    lock_release (&filesys_lock);
+  t->executable = file;
+  return success;
+}
+
+/* load() helpers. */
+
+/* Opens the executable FILE_NAME, denies writes to it for as
+   long as it stays open, and verifies its headers.  Returns the
+   executable, or a null pointer after printing a message if it
+   cannot be opened or is not a valid executable. */
+static struct file *
+open_executable (const char *file_name)
+{
+  struct file *file;
+
+  lock_acquire (&filesys_lock);
   file = filesys_open (file_name);
   if (file == NULL) 
     {
+      lock_release (&filesys_lock);
       printf ("load: %s: open failed\n", file_name);
-      goto done; 
+      return NULL;
+    }
+  file_deny_write (file);
+  if (exec_cache_get (file) == NULL)
+    {
+      file_close (file);
+      lock_release (&filesys_lock);
+      printf ("load: %s: error loading executable\n", file_name);
+      return NULL;
     }
+  lock_release (&filesys_lock);
+  return file;
+}
+
+#ifndef VM
+static bool install_page (void *upage, void *kpage, bool writable);
+#endif
+
+/* Frees the contents of exec cache entry IMG, leaving it free. */
+static void
+exec_image_clear (struct exec_image *img)
+{
+  inode_close (img->inode);
+  free (img->segments);
+  img->inode = NULL;
+  img->segments = NULL;
+  img->segment_cnt = 0;
+}
+
+/* Reads and verifies the ELF header and program headers of FILE
+   into free exec cache entry IMG.  Returns true if successful,
+   false if FILE is not a valid executable or memory is short,
+   leaving IMG free. */
+static bool
+read_image (struct file *file, struct exec_image *img)
+{
+  struct Elf32_Ehdr ehdr;
+  off_t file_ofs;
+  int i;
 
   /* Read and verify executable header. */
-  if (file_read (file, &ehdr, sizeof ehdr) != sizeof ehdr
+  if (file_read_at (file, &ehdr, sizeof ehdr, 0) != sizeof ehdr
       || memcmp (ehdr.e_ident, "\177ELF\1\1\1", 7)
       || ehdr.e_type != 2
       || ehdr.e_machine != 3
       || ehdr.e_version != 1
       || ehdr.e_phentsize != sizeof (struct Elf32_Phdr)
       || ehdr.e_phnum > 1024) 
-    {
-      printf ("load: %s: error loading executable\n", file_name);
-      goto done; 
-    }
+    return false;
+  img->entry = ehdr.e_entry;
+  img->end = 0;
+  img->segments = malloc (ehdr.e_phnum * sizeof *img->segments);
+  if (img->segments == NULL && ehdr.e_phnum > 0)
+    return false;
 
   /* Read program headers. */
   file_ofs = ehdr.e_phoff;
@@ -248,12 +699,10 @@ load (const char *file_name, void (**eip) (void), void **esp)
     {
       struct Elf32_Phdr phdr;
 
-      if (file_ofs < 0 || file_ofs > file_length (file))
-        goto done;
-      file_seek (file, file_ofs);
-
-      if (file_read (file, &phdr, sizeof phdr) != sizeof phdr)
-        goto done;
+      if (file_ofs < 0 || file_ofs > file_length (file)
+          || file_read_at (file, &phdr, sizeof phdr,
+                           file_ofs) != sizeof phdr)
+        goto fail;
       file_ofs += sizeof phdr;
       switch (phdr.p_type) 
         {
@@ -267,58 +716,96 @@ load (const char *file_name, void (**eip) (void), void **esp)
         case PT_DYNAMIC:
         case PT_INTERP:
         case PT_SHLIB:
-          goto done;
+          goto fail;
         case PT_LOAD:
           if (validate_segment (&phdr, file)) 
             {
-              bool writable = (phdr.p_flags & PF_W) != 0;
-              uint32_t file_page = phdr.p_offset & ~PGMASK;
-              uint32_t mem_page = phdr.p_vaddr & ~PGMASK;
+              struct exec_segment *s = &img->segments[img->segment_cnt++];
               uint32_t page_offset = phdr.p_vaddr & PGMASK;
-              uint32_t read_bytes, zero_bytes;
+
+              s->writable = (phdr.p_flags & PF_W) != 0;
+              s->file_page = phdr.p_offset & ~PGMASK;
+              s->mem_page = phdr.p_vaddr & ~PGMASK;
               if (phdr.p_filesz > 0)
                 {
                   /* Normal segment.
                      Read initial part from disk and zero the rest. */
-                  read_bytes = page_offset + phdr.p_filesz;
-                  zero_bytes = (ROUND_UP (page_offset + phdr.p_memsz, PGSIZE)
-                                - read_bytes);
+                  s->read_bytes = page_offset + phdr.p_filesz;
+                  s->zero_bytes = (ROUND_UP (page_offset + phdr.p_memsz,
+                                             PGSIZE)
+                                   - s->read_bytes);
                 }
               else 
                 {
                   /* Entirely zero.
                      Don't read anything from disk. */
-                  read_bytes = 0;
-                  zero_bytes = ROUND_UP (page_offset + phdr.p_memsz, PGSIZE);
+                  s->read_bytes = 0;
+                  s->zero_bytes = ROUND_UP (page_offset + phdr.p_memsz,
+                                            PGSIZE);
                 }
-              if (!load_segment (file, file_page, (void *) mem_page,
-                                 read_bytes, zero_bytes, writable))
-                goto done;
+              if (phdr.p_vaddr + phdr.p_memsz > img->end)
+                img->end = phdr.p_vaddr + phdr.p_memsz;
             }
           else
-            goto done;
+            goto fail;
           break;
         }
     }
+  return true;
 
-  /* Set up stack. */
-  if (!setup_stack (esp))
-    goto done;
+ fail:
+  exec_image_clear (img);
+  return false;
+}
 
-  /* Start address. */
-  *eip = (void (*) (void)) ehdr.e_entry;
+/* Returns the verified headers of executable FILE, from the exec
+   cache if they are there, otherwise reading them from FILE and
+   adding them to the cache in place of a stale or the least
+   recently used entry.  Returns a null pointer if FILE is not a
+   valid executable or memory is short.  The caller must hold
+   filesys_lock, and may use the returned entry only until it
+   releases it. */
+static struct exec_image *
+exec_cache_get (struct file *file)
+{
+  struct inode *inode = file_get_inode (file);
+  block_sector_t inumber = inode_get_inumber (inode);
+  unsigned generation = inode_get_generation (inode);
+  struct exec_image *victim = &exec_cache[0];
+  int i;
 
-  success = true;
+  ASSERT (lock_held_by_current_thread (&filesys_lock));
 
- done:
-  /* We arrive here whether the load is successful or not. */
-  file_close (file);
-  return success;
-}
-
-/* load() helpers. */
+  exec_clock++;
+  for (i = 0; i < EXEC_CACHE_CNT; i++)
+    {
+      struct exec_image *img = &exec_cache[i];
 
-static bool install_page (void *upage, void *kpage, bool writable);
+      if (img->inode != NULL && inode_get_inumber (img->inode) == inumber)
+        {
+          if (img->generation == generation)
+            {
+              img->last_used = exec_clock;
+              return img;
+            }
+
+          /* The file was written since we read it. */
+          victim = img;
+          break;
+        }
+      if (victim->inode != NULL
+          && (img->inode == NULL || img->last_used < victim->last_used))
+        victim = img;
+    }
+
+  exec_image_clear (victim);
+  if (!read_image (file, victim))
+    return NULL;
+  victim->inode = inode_reopen (inode);
+  victim->generation = generation;
+  victim->last_used = exec_clock;
+  return victim;
+}
 
 /* Checks whether PHDR describes a valid, loadable segment in
    FILE and returns true if so, false otherwise. */
@@ -379,6 +866,43 @@ validate_segment (const struct Elf32_Phdr *phdr, struct file *file)
 
    Return true if successful, false if a memory allocation error
    or disk read error occurs. */
+#ifdef VM
+/* With virtual memory, pages are only recorded in the
+   supplemental page table here and read in on first access.
+   Read-only file pages are then shared between all processes
+   running the same executable. */
+static bool
+load_segment (struct file *file, off_t ofs, uint8_t *upage,
+              uint32_t read_bytes, uint32_t zero_bytes, bool writable) 
+{
+  ASSERT ((read_bytes + zero_bytes) % PGSIZE == 0);
+  ASSERT (pg_ofs (upage) == 0);
+  ASSERT (ofs % PGSIZE == 0);
+
+  while (read_bytes > 0 || zero_bytes > 0) 
+    {
+      size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
+      size_t page_zero_bytes = PGSIZE - page_read_bytes;
+      struct page *p = page_alloc (upage, writable);
+      if (p == NULL)
+        return false;
+
+      if (page_read_bytes > 0)
+        {
+          p->file = file;
+          p->file_ofs = ofs;
+          p->read_bytes = page_read_bytes;
+        }
+
+      /* Advance. */
+      read_bytes -= page_read_bytes;
+      zero_bytes -= page_zero_bytes;
+      ofs += page_read_bytes;
+      upage += PGSIZE;
+    }
+  return true;
+}
+#else
 static bool
 load_segment (struct file *file, off_t ofs, uint8_t *upage,
               uint32_t read_bytes, uint32_t zero_bytes, bool writable) 
@@ -423,27 +947,103 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
     }
   return true;
 }
+#endif
+
+/* Counts the space-separated words in CMD_LINE, storing the
+   count into *ARGC.  Returns the bytes the words occupy with a
+   null terminator each. */
+static size_t
+measure_arguments (const char *cmd_line, int *argc)
+{
+  size_t size = 0;
 
-/* Create a minimal stack by mapping a zeroed page at the top of
-   user virtual memory. */
+  *argc = 0;
+  for (;;)
+    {
+      size_t len;
+
+      cmd_line += strspn (cmd_line, " ");
+      if (*cmd_line == '\0')
+        return size;
+      len = strcspn (cmd_line, " ");
+      cmd_line += len;
+      size += len + 1;
+      (*argc)++;
+    }
+}
+
+/* Maps as many zeroed pages at the top of user virtual memory as
+   it takes to pass the arguments in EXEC to main(), and lays out
+   the stack: the argument strings, argv[], argv, argc, and a
+   fake return address, as the 80x86 calling convention
+   requires.  Each string is copied once, straight from EXEC to
+   its final place.  Stores the initial stack pointer into *ESP.
+   Returns true if successful, false if the arguments take more
+   than ARG_MAX bytes or memory is short. */
 static bool
-setup_stack (void **esp) 
+setup_stack (const struct exec_info *exec, void **esp) 
 {
-  uint8_t *kpage;
-  bool success = false;
+  const char *cmd_line = exec->cmd_line;
+  char *strings, **argv;
+  size_t size;
+  uint32_t *sp;
+  uint8_t *upage;
+  int argc, i;
 
-  kpage = palloc_get_page (PAL_USER | PAL_ZERO);
-  if (kpage != NULL) 
+  if (cmd_line != NULL)
+    size = measure_arguments (cmd_line, &argc);
+  else
     {
-      success = install_page (((uint8_t *) PHYS_BASE) - PGSIZE, kpage, true);
-      if (success)
-        *esp = PHYS_BASE;
-      else
-        palloc_free_page (kpage);
+      size = exec->args_size;
+      argc = exec->argc;
     }
-  return success;
+
+  /* Compute the layout from the top down: the strings, then
+     argv[] word-aligned, then the three words for main(). */
+  strings = (char *) PHYS_BASE - size;
+  argv = (char **) ((uintptr_t) strings & ~3u) - (argc + 1);
+  sp = (uint32_t *) argv - 3;
+  if ((uint8_t *) PHYS_BASE - (uint8_t *) sp > ARG_MAX)
+    return false;
+
+  for (upage = pg_round_down (sp); upage < (uint8_t *) PHYS_BASE;
+       upage += PGSIZE)
+    if (!add_zero_page (upage))
+      return false;
+
+  /* Copy the strings into place, argv[0] lowest. */
+  if (cmd_line != NULL)
+    for (i = 0; i < argc; i++)
+      {
+        size_t len;
+
+        cmd_line += strspn (cmd_line, " ");
+        len = strcspn (cmd_line, " ");
+        memcpy (strings, cmd_line, len);
+        strings[len] = '\0';
+        argv[i] = strings;
+        strings += len + 1;
+        cmd_line += len;
+      }
+  else
+    {
+      memcpy (strings, exec->args, size);
+      for (i = 0; i < argc; i++)
+        {
+          argv[i] = strings;
+          strings += strlen (strings) + 1;
+        }
+    }
+  argv[argc] = NULL;
+
+  sp[0] = 0;
+  sp[1] = argc;
+  sp[2] = (uint32_t) argv;
+  *esp = sp;
+  return true;
 }
 
+#ifndef VM
 /* Adds a mapping from user virtual address UPAGE to kernel
    virtual address KPAGE to the page table.
    If WRITABLE is true, the user process may modify the page;
@@ -463,3 +1063,87 @@ install_page (void *upage, void *kpage, bool writable)
   return (pagedir_get_page (t->pagedir, upage) == NULL
           && pagedir_set_page (t->pagedir, upage, kpage, writable));
 }
+#endif
+
+/* Grows or shrinks the current process's heap by INCREMENT
+   bytes, as the sbrk system call.  Returns the old end of the
+   heap, or (void *) -1 if the heap would shrink below its start
+   or grow into the stack region or into another mapping, or if
+   memory is short.
+
+   With virtual memory, growing the heap only moves the break, and
+   page_grow_heap() adds each page on first access, so that a
+   large increment costs no memory up front.  Without it, pages
+   are allocated right away. */
+void *
+process_sbrk (intptr_t increment)
+{
+  struct thread *t = thread_current ();
+  uint8_t *old_brk = t->heap_brk;
+  uint8_t *new_brk = old_brk + increment;
+  uint8_t *upage;
+
+  if (t->heap_start == NULL
+      || (increment < 0
+          ? new_brk < t->heap_start || new_brk > old_brk
+          : new_brk < old_brk
+            || new_brk > (uint8_t *) PHYS_BASE - STACK_MAX))
+    return (void *) -1;
+
+#ifdef VM
+  if (new_brk > old_brk && mmap_overlaps (pg_round_up (old_brk), new_brk))
+    return (void *) -1;
+#else
+  for (upage = pg_round_up (old_brk); upage < new_brk; upage += PGSIZE)
+    if (!add_zero_page (upage))
+      {
+        while (upage > (uint8_t *) pg_round_up (old_brk))
+          remove_zero_page (upage -= PGSIZE);
+        return (void *) -1;
+      }
+#endif
+  for (upage = pg_round_up (new_brk); upage < old_brk; upage += PGSIZE)
+    remove_zero_page (upage);
+
+  t->heap_brk = new_brk;
+  return old_brk;
+}
+
+/* Adds a zeroed, writable page at UPAGE to the current process,
+   for its heap or stack.  With virtual memory, the page is read
+   in on first access.  Returns false if UPAGE is in use or
+   memory is short. */
+static bool
+add_zero_page (void *upage)
+{
+#ifdef VM
+  return page_alloc (upage, true) != NULL;
+#else
+  uint8_t *kpage = palloc_get_page (PAL_USER | PAL_ZERO);
+  if (kpage == NULL)
+    return false;
+  if (!install_page (upage, kpage, true))
+    {
+      palloc_free_page (kpage);
+      return false;
+    }
+  return true;
+#endif
+}
+
+/* Removes the page at UPAGE, added with add_zero_page() or, for
+   a heap page, on first access, from the current process. */
+static void
+remove_zero_page (void *upage)
+{
+#ifdef VM
+  struct page *p = page_lookup (upage);
+  if (p != NULL)
+    page_free (p);
+#else
+  struct thread *t = thread_current ();
+  void *kpage = pagedir_get_page (t->pagedir, upage);
+  pagedir_clear_page (t->pagedir, upage);
+  palloc_free_page (kpage);
+#endif
+}
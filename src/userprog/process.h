@@ -1,11 +1,47 @@
 #ifndef USERPROG_PROCESS_H
 #define USERPROG_PROCESS_H
 
+#include "threads/synch.h"
 #include "threads/thread.h"
 
-tid_t process_execute (const char *file_name);
+/* Exit status of a child process.
+
+   Shared between the child and its parent, so that the parent
+   can still learn the child's exit status after the child's
+   thread has been destroyed, and freed when both are done with
+   it. */
+struct child
+  {
+    tid_t tid;                  /* Child's thread identifier. */
+    int exit_status;            /* Child's exit status. */
+    struct semaphore dead;      /* Upped when the child exits. */
+    struct lock ref_lock;       /* Protects REF_CNT. */
+    int ref_cnt;                /* 2 = child and parent alive,
+                                   1 = one of them alive,
+                                   0 = both dead. */
+    struct list_elem elem;      /* Parent's `children' element. */
+  };
+
+/* Maximum size of a process's stack, in bytes.  The heap may
+   grow up to the bottom of this region. */
+#define STACK_MAX (8 * 1024 * 1024)
+
+/* Maximum size of the arguments passed to a new process, in
+   bytes: the words of its command line plus argv[] and the
+   words for main(). */
+#define ARG_MAX (64 * 1024)
+
+extern bool process_print_rusage;
+
+void process_init (void);
+tid_t process_execute (const char *cmd_line);
+tid_t process_spawn (const char *file_name, const char *args,
+                     size_t args_size, int argc,
+                     const int *fd_map, int fd_cnt);
 int process_wait (tid_t);
 void process_exit (void);
 void process_activate (void);
+bool process_reap (void);
+void *process_sbrk (intptr_t increment);
 
 #endif /* userprog/process.h */
@@ -1,20 +1,1279 @@
 #include "userprog/syscall.h"
+#include <inttypes.h>
+#include <iovec.h>
+#include <ring.h>
+#include <round.h>
 #include <stdio.h>
+#include <string.h>
 #include <syscall-nr.h>
+#include "devices/block.h"
+#include "devices/input.h"
+#include "devices/shutdown.h"
+#include "filesys/file.h"
+#include "filesys/filesys.h"
+#include "threads/init.h"
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
 #include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pipe.h"
+#include "userprog/process.h"
+#include "userprog/tss.h"
+#include "userprog/uaccess.h"
+#include "userprog/vdso.h"
+#ifdef VM
+#include "vm/mmap.h"
+#include "vm/page.h"
+#endif
+
+/* Largest console write that write_iov() copies through a buffer
+   on the kernel stack instead of a page. */
+#define CONSOLE_FAST_MAX 256
+
+/* An open file descriptor, for a file or for one end of a
+   pipe. */
+struct file_descriptor
+  {
+    int handle;                 /* File handle. */
+    struct file *file;          /* Open file, or null for a pipe. */
+    struct pipe *pipe;          /* Pipe, or null for a file. */
+    bool writer;                /* Write end of PIPE? */
+  };
+
+/* Most handles a process may have, counting the unused slots
+   below its highest open handle. */
+#define FD_MAX 8192
+
+/* Bits in each element of a thread's `fd_map'. */
+#define FD_MAP_BITS 32
+
+/* Most handles spawn() can pass to a new process. */
+#define SPAWN_FD_MAX 32
 
 static void syscall_handler (struct intr_frame *);
+static void kill_process (void) NO_RETURN;
+static void copy_in (void *kdst, const void *usrc, size_t size);
+static void copy_out (void *udst, const void *ksrc, size_t size);
+static char *copy_in_string (const char *us);
+static int install_fd (struct file_descriptor *, int handle);
+static struct file_descriptor *find_fd (struct thread *, int handle);
+static struct file_descriptor *lookup_fd (int handle);
+static struct file_descriptor *lookup_file (int handle);
+static struct file_descriptor *dup_fd (const struct file_descriptor *,
+                                       int handle);
+static void close_fd (struct file_descriptor *);
+
+static void sys_halt (void) NO_RETURN;
+static void sys_exit (int status) NO_RETURN;
+static int sys_exec (const char *ucmd_line);
+static int sys_spawn (const char *ufile, const char **uargv,
+                      const int *ufd_map);
+static int sys_wait (tid_t);
+static bool sys_create (const char *ufile, unsigned initial_size);
+static bool sys_remove (const char *ufile);
+static int sys_open (const char *ufile);
+static int sys_filesize (int handle);
+static int sys_read (int handle, void *ubuf, unsigned size);
+static int sys_write (int handle, const void *ubuf, unsigned size);
+static int sys_readv (int handle, const struct iovec *uiov, int cnt);
+static int sys_writev (int handle, const struct iovec *uiov, int cnt);
+static int sys_ring_enter (struct ring *uring);
+static int sys_copy_file_range (int in_handle, int out_handle,
+                                unsigned size);
+static void sys_seek (int handle, unsigned position);
+static unsigned sys_tell (int handle);
+static void sys_close (int handle);
+static bool sys_pipe (int *uhandles);
+static int sys_dup2 (int old_handle, int new_handle);
+static bool sys_gettime (uint64_t *uns);
+static void *sys_sbrk (intptr_t increment);
+#ifdef VM
+static int sys_mmap (int handle, void *addr);
+static void sys_munmap (int mapid);
+static bool sys_madvise (void *addr, unsigned length, int advice);
+#endif
+static bool sys_getrusage (struct rusage *uusage);
+static bool sys_sysenter (void);
+
+/* A system call. */
+typedef int syscall_function (int, int, int);
+struct syscall
+  {
+    const char *name;           /* Name, for statistics. */
+    size_t arg_cnt;             /* Number of arguments. */
+    syscall_function *func;     /* Implementation. */
+  };
+
+/* Table of system calls, indexed by system call number. */
+static const struct syscall syscall_table[] =
+  {
+#define SYSCALL(NR, NAME, ARG_CNT)                                    \
+    [NR] = {#NAME, ARG_CNT,                                             \
+            (syscall_function *) (void (*) (void)) sys_##NAME}
+    SYSCALL (SYS_HALT, halt, 0),
+    SYSCALL (SYS_EXIT, exit, 1),
+    SYSCALL (SYS_EXEC, exec, 1),
+    SYSCALL (SYS_WAIT, wait, 1),
+    SYSCALL (SYS_CREATE, create, 2),
+    SYSCALL (SYS_REMOVE, remove, 1),
+    SYSCALL (SYS_OPEN, open, 1),
+    SYSCALL (SYS_FILESIZE, filesize, 1),
+    SYSCALL (SYS_READ, read, 3),
+    SYSCALL (SYS_WRITE, write, 3),
+    SYSCALL (SYS_SEEK, seek, 2),
+    SYSCALL (SYS_TELL, tell, 1),
+    SYSCALL (SYS_CLOSE, close, 1),
+#ifdef VM
+    SYSCALL (SYS_MMAP, mmap, 2),
+    SYSCALL (SYS_MUNMAP, munmap, 1),
+    SYSCALL (SYS_MADVISE, madvise, 3),
+#endif
+    SYSCALL (SYS_GETRUSAGE, getrusage, 1),
+    SYSCALL (SYS_SYSENTER, sysenter, 0),
+    SYSCALL (SYS_READV, readv, 3),
+    SYSCALL (SYS_WRITEV, writev, 3),
+    SYSCALL (SYS_RING_ENTER, ring_enter, 1),
+    SYSCALL (SYS_COPY_FILE_RANGE, copy_file_range, 3),
+    SYSCALL (SYS_PIPE, pipe, 1),
+    SYSCALL (SYS_DUP2, dup2, 2),
+    SYSCALL (SYS_GETTIME, gettime, 1),
+    SYSCALL (SYS_SBRK, sbrk, 1),
+    SYSCALL (SYS_SPAWN, spawn, 3),
+#undef SYSCALL
+  };
+
+/* Number of entries in syscall_table. */
+#define SYSCALL_CNT (sizeof syscall_table / sizeof *syscall_table)
+
+/* Statistics for each system call.  Updated without locking, so
+   the counts may be slightly low when processes race. */
+static uint64_t call_cnt[SYSCALL_CNT];     /* Number of calls. */
+static uint64_t call_cycles[SYSCALL_CNT];  /* Time spent, in TSC cycles. */
+
+/* Returns the CPU's time-stamp counter. */
+static inline uint64_t
+rdtsc (void)
+{
+  uint64_t tsc;
+  asm volatile ("rdtsc" : "=A" (tsc));
+  return tsc;
+}
+
+/* If true, user programs may make system calls with SYSENTER as
+   well as with "int $0x30", set with -sysenter. */
+bool syscall_use_sysenter;
+
+/* Model-specific registers that configure SYSENTER.  See
+   [IA32-v3a] 4.8.7 "Performing Fast Calls to System Procedures
+   with the SYSENTER and SYSEXIT Instructions". */
+#define MSR_SYSENTER_CS 0x174   /* Kernel code segment. */
+#define MSR_SYSENTER_ESP 0x175  /* Kernel stack pointer. */
+#define MSR_SYSENTER_EIP 0x176  /* Kernel entry point. */
+
+/* Entry point in sysenter.S. */
+void sysenter_entry (void);
+
+/* Writes VALUE to model-specific register MSR. */
+static void
+wrmsr (uint32_t msr, uint32_t value)
+{
+  asm volatile ("wrmsr" : : "c" (msr), "a" (value), "d" (0));
+}
 
 void
-syscall_init (void) 
+syscall_init (void)
 {
   intr_register_int (0x30, 3, INTR_ON, syscall_handler, "syscall");
+
+  /* SYSENTER switches to the stack in MSR_SYSENTER_ESP, which
+     cannot follow the running thread without being rewritten on
+     every context switch.  Instead it points to the TSS, from
+     which sysenter_entry loads the thread's kernel stack. */
+  if (syscall_use_sysenter && (cpuid_features () & CPUID_SEP) != 0)
+    {
+      wrmsr (MSR_SYSENTER_CS, SEL_KCSEG);
+      wrmsr (MSR_SYSENTER_ESP, (uintptr_t) tss_get ());
+      wrmsr (MSR_SYSENTER_EIP, (uintptr_t) sysenter_entry);
+    }
+  else
+    syscall_use_sysenter = false;
+}
+
+/* System call handler.  The system call number and its
+   arguments are on the user stack, each taking one word. */
+static void
+syscall_handler (struct intr_frame *f)
+{
+  const struct syscall *sc;
+  uint32_t *esp = f->esp;
+  int args[3];
+  uint32_t call_nr;
+  uint64_t start;
+
+  thread_current ()->user_esp = f->esp;
+#ifdef VM
+  page_sample_working_set ();
+#endif
+
+  copy_in (&call_nr, esp, sizeof call_nr);
+  if (call_nr >= SYSCALL_CNT || syscall_table[call_nr].func == NULL)
+    kill_process ();
+  sc = &syscall_table[call_nr];
+
+  /* Fetch the arguments, all in one copy. */
+  ASSERT (sc->arg_cnt <= sizeof args / sizeof *args);
+  memset (args, 0, sizeof args);
+  copy_in (args, esp + 1, sizeof *args * sc->arg_cnt);
+
+  /* Execute the system call, and set the return value.  Exit and
+     halt do not return, so only their calls are counted. */
+  call_cnt[call_nr]++;
+  start = rdtsc ();
+  f->eax = sc->func (args[0], args[1], args[2]);
+  call_cycles[call_nr] += rdtsc () - start;
+}
+
+/* Handles a system call made with SYSENTER.  Called by
+   sysenter_entry, which fills in only the user stack pointer and
+   return address in F, and which returns F's eax member to the
+   user program. */
+void
+syscall_sysenter (struct intr_frame *f)
+{
+  syscall_handler (f);
+}
+
+/* Prints statistics for each system call that has been made. */
+void
+syscall_print_stats (void)
+{
+  size_t i;
+
+  for (i = 0; i < SYSCALL_CNT; i++)
+    if (call_cnt[i] > 0)
+      printf ("System call %s: %"PRIu64" calls, %"PRIu64" cycles\n",
+              syscall_table[i].name, call_cnt[i], call_cycles[i]);
+}
+
+/* Closes all of the current process's open files.  Called by
+   process_exit(). */
+void
+syscall_exit (void)
+{
+  struct thread *cur = thread_current ();
+  int i;
+
+  for (i = 0; i < cur->fd_cnt / FD_MAP_BITS; i++)
+    while (cur->fd_map[i] != 0)
+      close_fd (cur->fds[i * FD_MAP_BITS + __builtin_ctz (cur->fd_map[i])]);
+  free (cur->fds);
+  free (cur->fd_map);
+  cur->fds = NULL;
+  cur->fd_map = NULL;
+  cur->fd_cnt = 0;
+}
+
+/* Gives the current process, which PARENT is starting, copies of
+   some of PARENT's handles.  If FD_MAP is non-null, handle I,
+   for each I < FD_CNT, becomes a copy of PARENT's handle
+   FD_MAP[I].  Otherwise, only PARENT's standard input and output
+   handles are inherited, if PARENT has redirected them.  Returns
+   false if memory is short. */
+bool
+syscall_inherit (struct thread *parent, const int *fd_map, int fd_cnt)
+{
+  static const int std_map[] = {STDIN_FILENO, STDOUT_FILENO};
+  int handle;
+
+  if (fd_map == NULL)
+    {
+      fd_map = std_map;
+      fd_cnt = sizeof std_map / sizeof *std_map;
+    }
+  for (handle = 0; handle < fd_cnt; handle++)
+    {
+      struct file_descriptor *src = find_fd (parent, fd_map[handle]);
+      if (src != NULL)
+        {
+          struct file_descriptor *fd = dup_fd (src, handle);
+          if (fd == NULL)
+            return false;
+          if (install_fd (fd, handle) < 0)
+            {
+              close_fd (fd);
+              return false;
+            }
+        }
+    }
+  return true;
+}
+
+/* Terminates the current process with exit status -1, as is
+   done for a process that passes a bad argument to a system
+   call. */
+static void
+kill_process (void)
+{
+  sys_exit (-1);
+}
+
+/* Copies SIZE bytes from user address USRC to KDST.
+   Terminates the process if USRC is invalid. */
+static void
+copy_in (void *kdst, const void *usrc, size_t size)
+{
+  if (!copy_from_user (kdst, usrc, size))
+    kill_process ();
+}
+
+/* Copies SIZE bytes from KSRC to user address UDST.
+   Terminates the process if UDST is invalid. */
+static void
+copy_out (void *udst, const void *ksrc, size_t size)
+{
+  if (!copy_to_user (udst, ksrc, size))
+    kill_process ();
+}
+
+/* Copies the null-terminated string at user address US into a
+   new page and returns it.  Strings longer than a page are
+   truncated.  Terminates the process if US is invalid.  The
+   caller must free the page with palloc_free_page(). */
+static char *
+copy_in_string (const char *us)
+{
+  char *ks;
+
+  ks = palloc_get_page (0);
+  if (ks == NULL)
+    kill_process ();
+
+  if (strncpy_from_user (ks, us, PGSIZE) == SIZE_MAX)
+    {
+      palloc_free_page (ks);
+      kill_process ();
+    }
+  ks[PGSIZE - 1] = '\0';
+  return ks;
+}
+
+/* Halt system call. */
+static void
+sys_halt (void)
+{
+  shutdown_power_off ();
 }
 
+/* Exit system call. */
 static void
-syscall_handler (struct intr_frame *f UNUSED) 
+sys_exit (int status)
 {
-  printf ("system call!\n");
+  thread_current ()->exit_status = status;
   thread_exit ();
 }
+
+/* Replaces the one-page argument buffer *BUF, whose first USED
+   bytes are in use, by one of ARG_MAX bytes, and updates
+   *PAGE_CNT to match.  Returns false, leaving *BUF alone, if the
+   buffer is already that big or memory is short. */
+static bool
+grow_arg_buffer (char **buf, size_t *page_cnt, size_t used)
+{
+  size_t new_cnt = DIV_ROUND_UP (ARG_MAX, PGSIZE);
+  char *new_buf;
+
+  if (*page_cnt >= new_cnt)
+    return false;
+  new_buf = palloc_get_multiple (0, new_cnt);
+  if (new_buf == NULL)
+    return false;
+  memcpy (new_buf, *buf, used);
+  palloc_free_multiple (*buf, *page_cnt);
+  *buf = new_buf;
+  *page_cnt = new_cnt;
+  return true;
+}
+
+/* Exec system call.  The command line may be up to ARG_MAX
+   bytes long, although it is first copied into a single page,
+   which is almost always enough.  The new process builds its
+   stack straight from the copy made here. */
+static int
+sys_exec (const char *ucmd_line)
+{
+  size_t page_cnt = 1;
+  char *cmd_line;
+  size_t length;
+  tid_t tid;
+
+  cmd_line = palloc_get_page (0);
+  if (cmd_line == NULL)
+    return TID_ERROR;
+  for (;;)
+    {
+      length = strncpy_from_user (cmd_line, ucmd_line, page_cnt * PGSIZE);
+      if (length == SIZE_MAX)
+        {
+          palloc_free_multiple (cmd_line, page_cnt);
+          kill_process ();
+        }
+      if (length < page_cnt * PGSIZE)
+        break;
+      if (!grow_arg_buffer (&cmd_line, &page_cnt, 0))
+        {
+          palloc_free_multiple (cmd_line, page_cnt);
+          return TID_ERROR;
+        }
+    }
+  tid = process_execute (cmd_line);
+  palloc_free_multiple (cmd_line, page_cnt);
+  return tid;
+}
+
+/* Spawn system call.  Starts the program in FILE, passing it the
+   null-terminated array of strings ARGV as its arguments.  If
+   FD_MAP is non-null, it is an array of our handles, ending in
+   -1, and the new process gets a copy of FD_MAP[I] as its handle
+   I; a standard handle that we have not redirected gives it the
+   console.  Otherwise, handles are inherited as by exec.  A
+   program that is missing or not a valid executable fails
+   without creating a thread. */
+static int
+sys_spawn (const char *ufile, const char **uargv, const int *ufd_map)
+{
+  size_t page_cnt = 1;
+  int fd_map[SPAWN_FD_MAX];
+  int fd_cnt = 0;
+  char *file, *args;
+  size_t size = 0;
+  tid_t tid = TID_ERROR;
+  int argc;
+
+  /* Copy in FD_MAP, making sure that it names only our handles,
+     before anything that needs to be freed is allocated. */
+  if (ufd_map != NULL)
+    for (;; fd_cnt++)
+      {
+        int handle;
+
+        copy_in (&handle, ufd_map + fd_cnt, sizeof handle);
+        if (handle == -1)
+          break;
+        if (handle != STDIN_FILENO && handle != STDOUT_FILENO)
+          lookup_fd (handle);
+        if (fd_cnt >= SPAWN_FD_MAX)
+          return TID_ERROR;
+        fd_map[fd_cnt] = handle;
+      }
+
+  file = copy_in_string (ufile);
+  args = palloc_get_page (0);
+  if (args == NULL)
+    goto done;
+
+  /* Pack the argument strings one after another, in a single page
+     unless they do not fit. */
+  for (argc = 0; ; )
+    {
+      const char *uarg;
+      size_t length;
+
+      if (!copy_from_user (&uarg, uargv + argc, sizeof uarg))
+        goto bad;
+      if (uarg == NULL)
+        break;
+      length = strncpy_from_user (args + size, uarg,
+                                  page_cnt * PGSIZE - size);
+      if (length == SIZE_MAX)
+        goto bad;
+      if (length == page_cnt * PGSIZE - size)
+        {
+          if (!grow_arg_buffer (&args, &page_cnt, size))
+            goto done;
+          continue;
+        }
+      size += length + 1;
+      argc++;
+    }
+
+  tid = process_spawn (file, args, size, argc,
+                       ufd_map != NULL ? fd_map : NULL, fd_cnt);
+
+ done:
+  palloc_free_multiple (args, page_cnt);
+  palloc_free_page (file);
+  return tid;
+
+ bad:
+  palloc_free_multiple (args, page_cnt);
+  palloc_free_page (file);
+  kill_process ();
+}
+
+/* Wait system call. */
+static int
+sys_wait (tid_t child)
+{
+  return process_wait (child);
+}
+
+/* Create system call. */
+static bool
+sys_create (const char *ufile, unsigned initial_size)
+{
+  char *file = copy_in_string (ufile);
+  bool ok;
+
+  lock_acquire (&filesys_lock);
+  ok = filesys_create (file, initial_size);
+  lock_release (&filesys_lock);
+
+  palloc_free_page (file);
+  return ok;
+}
+
+/* Remove system call. */
+static bool
+sys_remove (const char *ufile)
+{
+  char *file = copy_in_string (ufile);
+  bool ok;
+
+  lock_acquire (&filesys_lock);
+  ok = filesys_remove (file);
+  lock_release (&filesys_lock);
+
+  palloc_free_page (file);
+  return ok;
+}
+
+/* Open system call. */
+static int
+sys_open (const char *ufile)
+{
+  char *file = copy_in_string (ufile);
+  struct file_descriptor *fd;
+  int handle = -1;
+
+  fd = malloc (sizeof *fd);
+  if (fd != NULL)
+    {
+      lock_acquire (&filesys_lock);
+      fd->file = filesys_open (file);
+      lock_release (&filesys_lock);
+      fd->pipe = NULL;
+      fd->writer = false;
+      fd->handle = -1;
+      if (fd->file != NULL)
+        {
+          handle = install_fd (fd, -1);
+          if (handle < 0)
+            close_fd (fd);
+        }
+      else
+        free (fd);
+    }
+
+  palloc_free_page (file);
+  return handle;
+}
+
+/* Makes room in the current process's descriptor table for at
+   least CNT handles.  Returns false if memory is short or CNT
+   exceeds FD_MAX. */
+static bool
+grow_fds (int cnt)
+{
+  struct thread *cur = thread_current ();
+  struct file_descriptor **fds;
+  uint32_t *fd_map;
+  int new_cnt;
+
+  if (cnt <= cur->fd_cnt)
+    return true;
+  if (cnt > FD_MAX)
+    return false;
+
+  new_cnt = cur->fd_cnt > 0 ? cur->fd_cnt : FD_MAP_BITS;
+  while (new_cnt < cnt)
+    new_cnt *= 2;
+
+  fds = realloc (cur->fds, new_cnt * sizeof *fds);
+  if (fds == NULL)
+    return false;
+  cur->fds = fds;
+  fd_map = realloc (cur->fd_map, new_cnt / FD_MAP_BITS * sizeof *fd_map);
+  if (fd_map == NULL)
+    return false;
+  cur->fd_map = fd_map;
+
+  memset (fds + cur->fd_cnt, 0, (new_cnt - cur->fd_cnt) * sizeof *fds);
+  memset (fd_map + cur->fd_cnt / FD_MAP_BITS, 0,
+          (new_cnt - cur->fd_cnt) / FD_MAP_BITS * sizeof *fd_map);
+  cur->fd_cnt = new_cnt;
+  return true;
+}
+
+/* Adds FD to the current process's descriptor table as HANDLE,
+   which must not be in use, or as the lowest free handle other
+   than STDIN_FILENO and STDOUT_FILENO if HANDLE is -1.  Returns
+   the handle, or -1 if memory is short or there are too many
+   handles. */
+static int
+install_fd (struct file_descriptor *fd, int handle)
+{
+  struct thread *cur = thread_current ();
+
+  if (handle < 0)
+    {
+      int i;
+
+      /* Find the first word of the map with a free bit, and the
+         first free bit in it.  Handles 0 and 1 are free only for
+         redirection with dup2(), even before the table exists. */
+      handle = cur->fd_cnt > 2 ? cur->fd_cnt : 2;
+      for (i = 0; i < cur->fd_cnt / FD_MAP_BITS; i++)
+        {
+          uint32_t used = cur->fd_map[i];
+          if (i == 0)
+            used |= (1u << STDIN_FILENO) | (1u << STDOUT_FILENO);
+          if (used != UINT32_MAX)
+            {
+              handle = i * FD_MAP_BITS + __builtin_ctz (~used);
+              break;
+            }
+        }
+    }
+  if (!grow_fds (handle + 1))
+    return -1;
+
+  ASSERT (cur->fds[handle] == NULL);
+  cur->fds[handle] = fd;
+  cur->fd_map[handle / FD_MAP_BITS] |= 1u << (handle % FD_MAP_BITS);
+  fd->handle = handle;
+  return handle;
+}
+
+/* Returns the file descriptor associated with HANDLE in thread
+   T, or a null pointer if there is none. */
+static struct file_descriptor *
+find_fd (struct thread *t, int handle)
+{
+  if (handle < 0 || handle >= t->fd_cnt)
+    return NULL;
+  return t->fds[handle];
+}
+
+/* Returns the file descriptor associated with the given HANDLE.
+   Terminates the process if HANDLE is not associated with an
+   open file or pipe. */
+static struct file_descriptor *
+lookup_fd (int handle)
+{
+  struct file_descriptor *fd = find_fd (thread_current (), handle);
+  if (fd == NULL)
+    kill_process ();
+  return fd;
+}
+
+/* Returns the file descriptor associated with the given HANDLE.
+   Terminates the process if HANDLE is not associated with an
+   open file, including if it is associated with a pipe. */
+static struct file_descriptor *
+lookup_file (int handle)
+{
+  struct file_descriptor *fd = lookup_fd (handle);
+  if (fd->file == NULL)
+    kill_process ();
+  return fd;
+}
+
+/* Returns a new file descriptor for HANDLE that refers to the
+   same file or pipe end as SRC, or a null pointer if memory is
+   short.  A file is reopened, so that the new descriptor has its
+   own position, which starts out the same as SRC's.  The caller
+   must add the new descriptor to the descriptor table with
+   install_fd(). */
+static struct file_descriptor *
+dup_fd (const struct file_descriptor *src, int handle)
+{
+  struct file_descriptor *fd = malloc (sizeof *fd);
+  if (fd == NULL)
+    return NULL;
+
+  *fd = *src;
+  fd->handle = handle;
+  if (fd->pipe != NULL)
+    pipe_open (fd->pipe, fd->writer);
+  else
+    {
+      lock_acquire (&filesys_lock);
+      fd->file = file_reopen (src->file);
+      if (fd->file != NULL)
+        file_seek (fd->file, file_tell (src->file));
+      lock_release (&filesys_lock);
+      if (fd->file == NULL)
+        {
+          free (fd);
+          return NULL;
+        }
+    }
+  return fd;
+}
+
+/* Closes FD, removes it from the current process's descriptor
+   table if it was installed there, and frees it. */
+static void
+close_fd (struct file_descriptor *fd)
+{
+  struct thread *cur = thread_current ();
+
+  if (fd->pipe != NULL)
+    pipe_close (fd->pipe, fd->writer);
+  else
+    {
+      lock_acquire (&filesys_lock);
+      file_close (fd->file);
+      lock_release (&filesys_lock);
+    }
+
+  if (find_fd (cur, fd->handle) == fd)
+    {
+      cur->fds[fd->handle] = NULL;
+      cur->fd_map[fd->handle / FD_MAP_BITS]
+        &= ~(1u << (fd->handle % FD_MAP_BITS));
+    }
+  free (fd);
+}
+
+/* Filesize system call. */
+static int
+sys_filesize (int handle)
+{
+  struct file_descriptor *fd = lookup_file (handle);
+  int size;
+
+  lock_acquire (&filesys_lock);
+  size = file_length (fd->file);
+  lock_release (&filesys_lock);
+
+  return size;
+}
+
+/* A position in an array of user buffers. */
+struct iov_cursor
+  {
+    const struct iovec *iov;    /* Current buffer. */
+    size_t cnt;                 /* Buffers left, including current. */
+    size_t ofs;                 /* Offset within current buffer. */
+  };
+
+/* Returns the number of bytes left in the buffers after cursor
+   C, but no more than MAX. */
+static size_t
+iov_left (const struct iov_cursor *c, size_t max)
+{
+  size_t left = 0;
+  size_t i;
+
+  for (i = 0; i < c->cnt && left < max; i++)
+    left += c->iov[i].iov_len - (i == 0 ? c->ofs : 0);
+  return left < max ? left : max;
+}
+
+/* Copies SIZE bytes between KBUF and the user buffers at cursor
+   C, into the user buffers if TO_USER is true and out of them
+   otherwise, and advances C past them.  Returns false if a user
+   buffer is invalid. */
+static bool
+iov_copy (struct iov_cursor *c, uint8_t *kbuf, size_t size, bool to_user)
+{
+  while (size > 0)
+    {
+      uint8_t *ubuf = (uint8_t *) c->iov->iov_base + c->ofs;
+      size_t chunk = c->iov->iov_len - c->ofs;
+      bool ok;
+
+      if (chunk > size)
+        chunk = size;
+      ok = (to_user
+            ? copy_to_user (ubuf, kbuf, chunk)
+            : copy_from_user (kbuf, ubuf, chunk));
+      if (!ok)
+        return false;
+
+      kbuf += chunk;
+      size -= chunk;
+      c->ofs += chunk;
+      if (c->ofs == c->iov->iov_len)
+        {
+          c->iov++;
+          c->cnt--;
+          c->ofs = 0;
+        }
+    }
+  return true;
+}
+
+/* Reads from the file or pipe open as HANDLE, or from the
+   keyboard if HANDLE is STDIN_FILENO and has not been redirected,
+   into the CNT user buffers in IOV, and returns the number of
+   bytes read.  A pipe read returns as soon as any data arrives.
+
+   Data is read into a kernel buffer a page at a time and copied
+   out afterward, so that no page fault on a user buffer can
+   occur while the file system lock is held.  Terminates the
+   process if a user buffer turns out to be invalid. */
+static int
+read_iov (int handle, const struct iovec *iov, size_t cnt)
+{
+  struct iov_cursor c = {iov, cnt, 0};
+  struct file_descriptor *fd = NULL;
+  uint8_t *kbuf;
+  int bytes_read = 0;
+
+  if (handle != STDIN_FILENO || find_fd (thread_current (), handle) != NULL)
+    fd = lookup_fd (handle);
+  kbuf = palloc_get_page (0);
+  if (kbuf == NULL)
+    return -1;
+  for (;;)
+    {
+      size_t chunk = iov_left (&c, PGSIZE);
+      off_t retval;
+
+      if (chunk == 0)
+        break;
+
+      /* Handle keyboard reads. */
+      if (fd == NULL)
+        {
+          for (retval = 0; (size_t) retval < chunk; retval++)
+            kbuf[retval] = input_getc ();
+        }
+      else if (fd->pipe != NULL)
+        retval = fd->writer ? -1 : pipe_read (fd->pipe, kbuf, chunk);
+      else
+        {
+          lock_acquire (&filesys_lock);
+          retval = file_read (fd->file, kbuf, chunk);
+          lock_release (&filesys_lock);
+        }
+      if (retval <= 0)
+        break;
+
+      if (!iov_copy (&c, kbuf, retval, true))
+        {
+          palloc_free_page (kbuf);
+          kill_process ();
+        }
+      bytes_read += retval;
+
+      /* Another pipe read would block until more data arrives. */
+      if ((size_t) retval != chunk || (fd != NULL && fd->pipe != NULL))
+        break;
+    }
+  palloc_free_page (kbuf);
+
+  return bytes_read;
+}
+
+/* Writes the CNT user buffers in IOV to the file or pipe open as
+   HANDLE, or to the console if HANDLE is STDOUT_FILENO and has
+   not been redirected, and returns the number of bytes written.
+   Like read_iov(), copies through a kernel buffer, which also
+   keeps console output from faulting while the console lock is
+   held. */
+static int
+write_iov (int handle, const struct iovec *iov, size_t cnt)
+{
+  struct iov_cursor c = {iov, cnt, 0};
+  struct file_descriptor *fd = NULL;
+  uint8_t *kbuf;
+  int bytes_written = 0;
+
+  if (handle != STDOUT_FILENO || find_fd (thread_current (), handle) != NULL)
+    fd = lookup_fd (handle);
+  else
+    {
+      /* Short console writes, such as a line of printf() output,
+         are copied to the stack and straight out to the console. */
+      size_t size = iov_left (&c, CONSOLE_FAST_MAX + 1);
+      if (size <= CONSOLE_FAST_MAX)
+        {
+          uint8_t line[CONSOLE_FAST_MAX];
+          if (!iov_copy (&c, line, size, false))
+            kill_process ();
+          putbuf ((const char *) line, size);
+          return size;
+        }
+    }
+
+  kbuf = palloc_get_page (0);
+  if (kbuf == NULL)
+    return -1;
+  for (;;)
+    {
+      size_t chunk = iov_left (&c, PGSIZE);
+      off_t retval;
+
+      if (chunk == 0)
+        break;
+      if (!iov_copy (&c, kbuf, chunk, false))
+        {
+          palloc_free_page (kbuf);
+          kill_process ();
+        }
+
+      /* Handle console writes. */
+      if (fd == NULL)
+        {
+          putbuf ((const char *) kbuf, chunk);
+          retval = chunk;
+        }
+      else if (fd->pipe != NULL)
+        retval = fd->writer ? pipe_write (fd->pipe, kbuf, chunk) : -1;
+      else
+        {
+          lock_acquire (&filesys_lock);
+          retval = file_write (fd->file, kbuf, chunk);
+          lock_release (&filesys_lock);
+        }
+      if (retval <= 0)
+        break;
+
+      bytes_written += retval;
+      if ((size_t) retval != chunk)
+        break;
+    }
+  palloc_free_page (kbuf);
+
+  return bytes_written;
+}
+
+/* Copies the array of CNT buffers at user address UIOV into IOV,
+   which must have room for IOV_MAX.  Returns false if CNT is out
+   of range.  Terminates the process if UIOV is invalid. */
+static bool
+copy_in_iov (struct iovec *iov, const struct iovec *uiov, int cnt)
+{
+  if (cnt < 0 || cnt > IOV_MAX)
+    return false;
+  copy_in (iov, uiov, cnt * sizeof *iov);
+  return true;
+}
+
+/* Read system call. */
+static int
+sys_read (int handle, void *ubuf, unsigned size)
+{
+  struct iovec iov = {ubuf, size};
+  return read_iov (handle, &iov, 1);
+}
+
+/* Readv system call. */
+static int
+sys_readv (int handle, const struct iovec *uiov, int cnt)
+{
+  struct iovec iov[IOV_MAX];
+
+  if (!copy_in_iov (iov, uiov, cnt))
+    return -1;
+  return read_iov (handle, iov, cnt);
+}
+
+/* Write system call. */
+static int
+sys_write (int handle, const void *ubuf, unsigned size)
+{
+  struct iovec iov = {(void *) ubuf, size};
+
+  return write_iov (handle, &iov, 1);
+}
+
+/* Writev system call. */
+static int
+sys_writev (int handle, const struct iovec *uiov, int cnt)
+{
+  struct iovec iov[IOV_MAX];
+
+  if (!copy_in_iov (iov, uiov, cnt))
+    return -1;
+  return write_iov (handle, iov, cnt);
+}
+
+/* Copy_file_range system call.  Copies up to SIZE bytes from the
+   file open as IN_HANDLE to the file open as OUT_HANDLE, starting
+   at each file's current position, and returns the number of
+   bytes copied.  The data goes through a kernel buffer and never
+   through user memory.  Each chunk ends on a sector boundary in
+   the input file, so that when both files are at the same offset
+   within a sector, as when copying a whole file, inode_read_at()
+   and inode_write_at() move whole sectors without bouncing. */
+static int
+sys_copy_file_range (int in_handle, int out_handle, unsigned size)
+{
+  struct file_descriptor *in = lookup_file (in_handle);
+  struct file_descriptor *out = lookup_file (out_handle);
+  uint8_t *kbuf;
+  int bytes_copied = 0;
+
+  kbuf = palloc_get_page (0);
+  if (kbuf == NULL)
+    return -1;
+  lock_acquire (&filesys_lock);
+  while (size > 0)
+    {
+      off_t sector_ofs = file_tell (in->file) % BLOCK_SECTOR_SIZE;
+      size_t chunk = PGSIZE - sector_ofs;
+      off_t bytes_read, bytes_written;
+
+      if (chunk > size)
+        chunk = size;
+      bytes_read = file_read (in->file, kbuf, chunk);
+      if (bytes_read <= 0)
+        break;
+      bytes_written = file_write (out->file, kbuf, bytes_read);
+      if (bytes_written > 0)
+        bytes_copied += bytes_written;
+      if (bytes_written != bytes_read)
+        break;
+      size -= bytes_read;
+    }
+  lock_release (&filesys_lock);
+  palloc_free_page (kbuf);
+
+  return bytes_copied;
+}
+
+/* Seek system call. */
+static void
+sys_seek (int handle, unsigned position)
+{
+  struct file_descriptor *fd = lookup_file (handle);
+
+  lock_acquire (&filesys_lock);
+  if ((off_t) position >= 0)
+    file_seek (fd->file, position);
+  lock_release (&filesys_lock);
+}
+
+/* Tell system call. */
+static unsigned
+sys_tell (int handle)
+{
+  struct file_descriptor *fd = lookup_file (handle);
+  unsigned position;
+
+  lock_acquire (&filesys_lock);
+  position = file_tell (fd->file);
+  lock_release (&filesys_lock);
+
+  return position;
+}
+
+/* Close system call. */
+static void
+sys_close (int handle)
+{
+  close_fd (lookup_fd (handle));
+}
+
+/* Pipe system call.  Creates a pipe and stores the handles for
+   its read end and its write end in UHANDLES[0] and UHANDLES[1]
+   respectively. */
+static bool
+sys_pipe (int *uhandles)
+{
+  struct file_descriptor *fds[2];
+  int handles[2];
+  struct pipe *p;
+  int i;
+
+  fds[0] = malloc (sizeof *fds[0]);
+  fds[1] = malloc (sizeof *fds[1]);
+  p = pipe_create ();
+  if (fds[0] == NULL || fds[1] == NULL || p == NULL)
+    {
+      free (fds[0]);
+      free (fds[1]);
+      if (p != NULL)
+        {
+          pipe_close (p, false);
+          pipe_close (p, true);
+        }
+      return false;
+    }
+
+  for (i = 0; i < 2; i++)
+    {
+      fds[i]->file = NULL;
+      fds[i]->pipe = p;
+      fds[i]->writer = i == 1;
+      fds[i]->handle = -1;
+    }
+  for (i = 0; i < 2; i++)
+    {
+      handles[i] = install_fd (fds[i], -1);
+      if (handles[i] < 0)
+        {
+          close_fd (fds[0]);
+          close_fd (fds[1]);
+          return false;
+        }
+    }
+  copy_out (uhandles, handles, sizeof handles);
+  return true;
+}
+
+/* Dup2 system call.  Makes NEW_HANDLE refer to the same file or
+   pipe as OLD_HANDLE, first closing NEW_HANDLE if it is open.
+   Redirecting STDIN_FILENO or STDOUT_FILENO this way replaces
+   the keyboard or console until it is closed again. */
+static int
+sys_dup2 (int old_handle, int new_handle)
+{
+  struct thread *cur = thread_current ();
+  struct file_descriptor *old = lookup_fd (old_handle);
+  struct file_descriptor *fd;
+
+  if (new_handle < 0)
+    return -1;
+  if (new_handle == old_handle)
+    return new_handle;
+
+  fd = dup_fd (old, new_handle);
+  if (fd == NULL)
+    return -1;
+  old = find_fd (cur, new_handle);
+  if (old != NULL)
+    close_fd (old);
+  if (install_fd (fd, new_handle) < 0)
+    {
+      close_fd (fd);
+      return -1;
+    }
+  return new_handle;
+}
+
+/* Gettime system call.  Stores the nanoseconds since boot in
+   *UNS.  User programs can read the same clock from the vDSO page
+   without a system call. */
+static bool
+sys_gettime (uint64_t *uns)
+{
+  uint64_t ns = vdso_clock_ns ();
+  copy_out (uns, &ns, sizeof ns);
+  return true;
+}
+
+/* Sbrk system call. */
+static void *
+sys_sbrk (intptr_t increment)
+{
+  return process_sbrk (increment);
+}
+
+/* Carries out the ring request SQE and returns its result. */
+static int
+ring_execute (const struct ring_sqe *sqe)
+{
+  switch (sqe->op)
+    {
+    case RING_OPEN:
+      return sys_open (sqe->buf);
+    case RING_READ:
+      return sys_read (sqe->fd, sqe->buf, sqe->size);
+    case RING_WRITE:
+      return sys_write (sqe->fd, sqe->buf, sqe->size);
+    case RING_SEEK:
+      sys_seek (sqe->fd, sqe->size);
+      return 0;
+    case RING_CLOSE:
+      sys_close (sqe->fd);
+      return 0;
+    default:
+      return -1;
+    }
+}
+
+/* Ring_enter system call.  Carries out the requests queued in
+   the ring at URING, as described in lib/ring.h, and returns the
+   number carried out.  A request fails or kills the process
+   exactly as the corresponding system call would. */
+static int
+sys_ring_enter (struct ring *uring)
+{
+  unsigned sq_head, sq_tail, cq_head, cq_tail;
+  int prev_result = 0;
+  int cnt = 0;
+
+  copy_in (&sq_head, &uring->sq_head, sizeof sq_head);
+  copy_in (&sq_tail, &uring->sq_tail, sizeof sq_tail);
+  copy_in (&cq_head, &uring->cq_head, sizeof cq_head);
+  copy_in (&cq_tail, &uring->cq_tail, sizeof cq_tail);
+
+  while (sq_head != sq_tail && cq_tail - cq_head < RING_ENTRIES)
+    {
+      struct ring_sqe sqe;
+      struct ring_cqe cqe;
+
+      copy_in (&sqe, &uring->sq[sq_head++ % RING_ENTRIES], sizeof sqe);
+      cqe.user_data = sqe.user_data;
+      if ((sqe.flags & RING_LINK) != 0 && prev_result < 0)
+        cqe.result = -1;
+      else
+        {
+          if (sqe.flags & RING_LINK)
+            sqe.size = prev_result;
+          cqe.result = ring_execute (&sqe);
+        }
+      copy_out (&uring->cq[cq_tail++ % RING_ENTRIES], &cqe, sizeof cqe);
+      prev_result = cqe.result;
+      cnt++;
+    }
+
+  copy_out (&uring->sq_head, &sq_head, sizeof sq_head);
+  copy_out (&uring->cq_tail, &cq_tail, sizeof cq_tail);
+  return cnt;
+}
+
+#ifdef VM
+/* Mmap system call. */
+static int
+sys_mmap (int handle, void *addr)
+{
+  struct file_descriptor *fd = lookup_file (handle);
+  return mmap_map (fd->file, addr);
+}
+
+/* Munmap system call. */
+static void
+sys_munmap (int mapid)
+{
+  mmap_unmap (mapid);
+}
+
+/* Madvise system call. */
+static bool
+sys_madvise (void *addr, unsigned length, int advice)
+{
+  return page_advise (addr, length, advice);
+}
+#endif
+
+/* Getrusage system call. */
+static bool
+sys_getrusage (struct rusage *uusage)
+{
+  copy_out (uusage, &thread_current ()->rusage, sizeof *uusage);
+  return true;
+}
+
+/* Sysenter system call. */
+static bool
+sys_sysenter (void)
+{
+  return syscall_use_sysenter;
+}
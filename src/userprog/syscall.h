@@ -1,6 +1,17 @@
 #ifndef USERPROG_SYSCALL_H
 #define USERPROG_SYSCALL_H
 
+#include <stdbool.h>
+
+struct intr_frame;
+struct thread;
+
+extern bool syscall_use_sysenter;
+
 void syscall_init (void);
+void syscall_sysenter (struct intr_frame *);
+bool syscall_inherit (struct thread *parent, const int *fd_map, int fd_cnt);
+void syscall_exit (void);
+void syscall_print_stats (void);
 
 #endif /* userprog/syscall.h */
@@ -0,0 +1,134 @@
+#include "userprog/uaccess.h"
+#include <stdint.h>
+#include "threads/interrupt.h"
+#include "threads/vaddr.h"
+
+/* Access to user memory.
+
+   The kernel reads and writes user buffers by dereferencing user
+   addresses directly, rather than checking each page against the
+   page table first.  A bad address then shows up as a page fault
+   in kernel context at one of the few instructions below.  Each
+   such instruction has an entry in the exception fixup table,
+   which the linker gathers into a table between
+   _start_ex_table and _end_ex_table.  The page fault handler
+   first tries to page in the faulting address as usual, and only
+   if that fails does it look up the faulting instruction in the
+   table and resume execution at the corresponding fixup address,
+   with the registers as the faulting instruction left them.
+
+   Only user addresses are ever dereferenced here, because a bad
+   kernel address would not fault. */
+
+/* An exception fixup table entry. */
+struct fixup
+  {
+    uintptr_t insn;             /* Address of instruction that may fault. */
+    uintptr_t resume;           /* Address to resume at if it does. */
+  };
+
+/* Exception fixup table, from the linker script. */
+extern const struct fixup _start_ex_table[], _end_ex_table[];
+
+/* Assembler directives that add a fixup table entry saying that a
+   fault at label INSN resumes at label RESUME. */
+#define FIXUP(INSN, RESUME)                             \
+        ".pushsection __ex_table, \"a\"\n\t"            \
+        ".long " #INSN ", " #RESUME "\n\t"              \
+        ".popsection\n"
+
+/* Returns true if the SIZE bytes starting at UADDR all lie in
+   user virtual memory. */
+static bool
+is_user_range (const void *uaddr, size_t size)
+{
+  uintptr_t first = (uintptr_t) uaddr;
+  return first + size >= first && first + size <= (uintptr_t) PHYS_BASE;
+}
+
+/* Copies SIZE bytes from SRC to DST, one of which is in user
+   memory, and returns the number of bytes left uncopied when a
+   bad user address stopped the copy, or 0 if all were copied. */
+static size_t
+copy_user (void *dst, const void *src, size_t size)
+{
+  asm volatile ("1: rep movsb\n"
+                "2:\n"
+                FIXUP (1b, 2b)
+                : "+D" (dst), "+S" (src), "+c" (size) : : "memory");
+  return size;
+}
+
+/* Copies SIZE bytes from user address USRC to KDST.  Returns
+   true if successful, false if USRC is a bad user address. */
+bool
+copy_from_user (void *kdst, const void *usrc, size_t size)
+{
+  return is_user_range (usrc, size) && copy_user (kdst, usrc, size) == 0;
+}
+
+/* Copies SIZE bytes from KSRC to user address UDST.  Returns
+   true if successful, false if UDST is a bad or read-only user
+   address. */
+bool
+copy_to_user (void *udst, const void *ksrc, size_t size)
+{
+  return is_user_range (udst, size) && copy_user (udst, ksrc, size) == 0;
+}
+
+/* Returns the byte at user address UADDR, which must be below
+   PHYS_BASE, or -1 if UADDR is a bad address. */
+static inline int
+get_user (const uint8_t *uaddr)
+{
+  int byte = -1;
+  asm volatile ("1: movzbl %1, %0\n"
+                "2:\n"
+                FIXUP (1b, 2b)
+                : "+r" (byte) : "m" (*uaddr));
+  return byte;
+}
+
+/* Copies the null-terminated string at user address USRC into
+   KDST, which has room for SIZE bytes.  Returns the length of
+   the string, not counting the null terminator.  If the string
+   does not fit, copies SIZE bytes and returns SIZE.  Returns
+   SIZE_MAX if USRC is a bad user address. */
+size_t
+strncpy_from_user (char *kdst, const char *usrc, size_t size)
+{
+  const uint8_t *us = (const uint8_t *) usrc;
+  size_t length;
+
+  for (length = 0; length < size; length++)
+    {
+      int c;
+
+      if ((uintptr_t) (us + length) >= (uintptr_t) PHYS_BASE)
+        return SIZE_MAX;
+      c = get_user (us + length);
+      if (c < 0)
+        return SIZE_MAX;
+      kdst[length] = c;
+      if (c == '\0')
+        return length;
+    }
+  return size;
+}
+
+/* If F is a page fault taken at an instruction in the exception
+   fixup table, arranges for F to resume at its fixup address and
+   returns true.  Otherwise returns false. */
+bool
+uaccess_fixup (struct intr_frame *f)
+{
+  const struct fixup *x;
+
+  for (x = _start_ex_table; x < _end_ex_table; x++)
+    if (x->insn == (uintptr_t) f->eip)
+      {
+        f->eip = (void (*) (void)) x->resume;
+        return true;
+      }
+  return false;
+}
@@ -0,0 +1,114 @@
+#include "userprog/vdso.h"
+#include <debug.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <vdso.h>
+#include "devices/timer.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "userprog/pagedir.h"
+
+/* Kernel address of the vDSO page, or a null pointer before
+   vdso_init() runs. */
+static struct vdso_data *vdso;
+
+/* Timer ticks over which to measure the TSC frequency. */
+#define CALIBRATE_TICKS 4
+
+static uint64_t rdtsc (void);
+static void wait_tick (void);
+
+/* Allocates the vDSO page and, if the CPU has a time-stamp
+   counter, measures its frequency against the timer.  Must be
+   called with interrupts on, before any user process starts. */
+void
+vdso_init (void)
+{
+  struct vdso_data *v;
+  uint64_t start;
+  int i;
+
+  ASSERT (intr_get_level () == INTR_ON);
+
+  v = palloc_get_page (PAL_ASSERT | PAL_ZERO);
+  v->ns_per_tick = 1000000000 / TIMER_FREQ;
+  if (cpuid_features () & CPUID_TSC)
+    {
+      wait_tick ();
+      start = rdtsc ();
+      for (i = 0; i < CALIBRATE_TICKS; i++)
+        wait_tick ();
+      v->tsc_freq = (rdtsc () - start) * TIMER_FREQ / CALIBRATE_TICKS;
+      if (v->tsc_freq != 0)
+        v->tsc_mult = (1000000000ULL << VDSO_SHIFT) / v->tsc_freq;
+      printf ("TSC runs at %'"PRIu64" Hz.\n", v->tsc_freq);
+    }
+
+  /* Publish the page only now, so that vdso_tick() sees it
+     fully initialized. */
+  barrier ();
+  vdso = v;
+}
+
+/* Updates the vDSO page for timer tick TICKS.  Called from the
+   timer interrupt handler. */
+void
+vdso_tick (int64_t ticks)
+{
+  if (vdso == NULL)
+    return;
+
+  vdso->seq++;
+  barrier ();
+  vdso->ticks = ticks;
+  vdso->ns = (uint64_t) ticks * vdso->ns_per_tick;
+  if (vdso->tsc_mult != 0)
+    vdso->tsc = rdtsc ();
+  barrier ();
+  vdso->seq++;
+}
+
+/* Maps the vDSO page read-only at VDSO_ADDR in page directory
+   PD.  Returns false if memory is short. */
+bool
+vdso_map (uint32_t *pd)
+{
+  ASSERT (vdso != NULL);
+  return pagedir_set_page (pd, VDSO_ADDR, vdso, false);
+}
+
+/* Unmaps the vDSO page from PD, so that pagedir_destroy() does
+   not free it. */
+void
+vdso_unmap (uint32_t *pd)
+{
+  pagedir_clear_page (pd, VDSO_ADDR);
+}
+
+/* Returns the nanoseconds since boot, the same way that user
+   programs read it from the vDSO page. */
+uint64_t
+vdso_clock_ns (void)
+{
+  return vdso_read_ns (vdso);
+}
+
+/* Returns the CPU's time-stamp counter. */
+static uint64_t
+rdtsc (void)
+{
+  uint64_t tsc;
+  asm volatile ("rdtsc" : "=A" (tsc));
+  return tsc;
+}
+
+/* Waits for the next timer tick to begin. */
+static void
+wait_tick (void)
+{
+  int64_t start = timer_ticks ();
+  while (timer_ticks () == start)
+    barrier ();
+}
@@ -0,0 +1,13 @@
+#ifndef USERPROG_VDSO_H
+#define USERPROG_VDSO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+void vdso_init (void);
+void vdso_tick (int64_t ticks);
+bool vdso_map (uint32_t *pd);
+void vdso_unmap (uint32_t *pd);
+uint64_t vdso_clock_ns (void);
+
+#endif /* userprog/vdso.h */
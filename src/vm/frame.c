@@ -0,0 +1,154 @@
+#include "vm/frame.h"
+#include <debug.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "vm/page.h"
+
+/* Frame table.
+
+   Every frame obtained from the user pool on behalf of a user
+   page is recorded here, so that the VM code can find all the
+   frames currently in use.  When the user pool runs dry, a
+   frame is reclaimed from some page by the clock algorithm. */
+static struct list frame_list;
+static struct lock frame_lock;
+
+/* Clock hand: the next frame to consider for eviction. */
+static struct list_elem *hand;
+
+static void *evict (void);
+
+/* Initializes the frame table. */
+void
+frame_init (void)
+{
+  list_init (&frame_list);
+  lock_init (&frame_lock);
+  hand = list_end (&frame_list);
+}
+
+/* Obtains a frame from the user pool for PAGE, which may be null
+   for a frame that has no single owner, evicting another page if
+   necessary.  If ZERO is true, the frame is filled with zeros.
+   Returns the new frame, or a null pointer if no frame is
+   available. */
+struct frame *
+frame_alloc (struct page *page, bool zero)
+{
+  struct frame *f = malloc (sizeof *f);
+  if (f == NULL)
+    return NULL;
+
+  f->kpage = palloc_get_page (PAL_USER | (zero ? PAL_ZERO : 0));
+  f->page = page;
+
+  lock_acquire (&frame_lock);
+  if (f->kpage == NULL)
+    {
+      f->kpage = evict ();
+      if (f->kpage == NULL)
+        {
+          lock_release (&frame_lock);
+          free (f);
+          return NULL;
+        }
+      if (zero)
+        memset (f->kpage, 0, PGSIZE);
+    }
+  list_push_back (&frame_list, &f->elem);
+  lock_release (&frame_lock);
+  return f;
+}
+
+/* Returns frame F to the user pool. */
+void
+frame_free (struct frame *f)
+{
+  if (f == NULL)
+    return;
+
+  lock_acquire (&frame_lock);
+  if (hand == &f->elem)
+    hand = list_next (hand);
+  list_remove (&f->elem);
+  lock_release (&frame_lock);
+
+  palloc_free_page (f->kpage);
+  free (f);
+}
+
+/* Chooses a frame with the clock algorithm, evicts the page in
+   it, and returns the frame's memory for reuse.  Returns a null
+   pointer if no page can be evicted.  frame_lock must be held.
+
+   Shared frames are never chosen.  Neither is a page whose
+   process holds its page lock, since the page may be in the
+   middle of being loaded; waiting for the lock could deadlock,
+   because that process may itself be waiting for frame_lock. */
+static void *
+evict (void)
+{
+  size_t i, frame_cnt = list_size (&frame_list);
+
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+
+  /* Two sweeps of the hand are enough to find a page that has
+     not been accessed, if any page can be evicted at all. */
+  for (i = 0; i < 2 * frame_cnt; i++)
+    {
+      struct frame *f;
+      struct page *p;
+      struct lock *page_lock;
+      uint32_t *pd;
+      bool was_held;
+      bool evicted = false;
+
+      if (hand == list_end (&frame_list))
+        hand = list_begin (&frame_list);
+      f = list_entry (hand, struct frame, elem);
+      hand = list_next (hand);
+
+      p = f->page;
+      if (p == NULL)
+        continue;
+      page_lock = &p->thread->page_lock;
+      was_held = lock_held_by_current_thread (page_lock);
+      if (!was_held && !lock_try_acquire (page_lock))
+        continue;
+
+      /* Give recently accessed pages a second chance, including
+         those whose accessed bit the working set sampler set
+         aside.  A process that is exiting clears its page
+         directory pointer before freeing its pages, which it does
+         with the page lock held. */
+      pd = p->thread->pagedir;
+      if (p->frame == f && pd != NULL)
+        {
+          if (pagedir_is_accessed (pd, p->upage))
+            {
+              pagedir_set_accessed (pd, p->upage, false);
+              p->seen = p->thread->ws_epoch;
+            }
+          else if (p->referenced)
+            p->referenced = false;
+          else
+            evicted = page_evict (p, pd);
+        }
+
+      if (!was_held)
+        lock_release (page_lock);
+      if (evicted)
+        {
+          void *kpage = f->kpage;
+          list_remove (&f->elem);
+          free (f);
+          return kpage;
+        }
+    }
+  return NULL;
+}
@@ -0,0 +1,21 @@
+#ifndef VM_FRAME_H
+#define VM_FRAME_H
+
+#include <list.h>
+#include <stdbool.h>
+
+struct page;
+
+/* A physical frame holding a user page. */
+struct frame
+  {
+    void *kpage;                /* Kernel virtual address of frame. */
+    struct page *page;          /* Page occupying frame, or null. */
+    struct list_elem elem;      /* `frame_list' element. */
+  };
+
+void frame_init (void);
+struct frame *frame_alloc (struct page *, bool zero);
+void frame_free (struct frame *);
+
+#endif /* vm/frame.h */
@@ -0,0 +1,166 @@
+#include "vm/mmap.h"
+#include <debug.h>
+#include <list.h>
+#include "filesys/file.h"
+#include "filesys/filesys.h"
+#include "threads/malloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "vm/page.h"
+
+/* A memory-mapped file.
+
+   Each page of the mapping is an ordinary page in the process's
+   supplemental page table, read from the file on first access.
+   Only pages that the process actually modified are written back
+   when the mapping goes away. */
+struct mapping
+  {
+    int mapid;                  /* Mapping identifier. */
+    struct file *file;          /* Private handle on the file. */
+    uint8_t *base;              /* Start of mapping. */
+    size_t page_cnt;            /* Number of pages mapped. */
+    struct list_elem elem;      /* struct thread `mappings' element. */
+  };
+
+static void unmap (struct mapping *);
+
+/* Returns true if any of the current process's mappings overlaps
+   the range of user virtual addresses from START up to END. */
+bool
+mmap_overlaps (const void *start, const void *end)
+{
+  struct thread *t = thread_current ();
+  struct list_elem *e;
+
+  for (e = list_begin (&t->mappings); e != list_end (&t->mappings);
+       e = list_next (e))
+    {
+      struct mapping *m = list_entry (e, struct mapping, elem);
+      if ((const uint8_t *) start < m->base + m->page_cnt * PGSIZE
+          && (const uint8_t *) end > m->base)
+        return true;
+    }
+  return false;
+}
+
+/* Maps FILE into the current process's address space starting
+   at ADDR, which must be page-aligned and nonzero.  The mapping
+   uses its own handle on FILE, so it is not affected if FILE is
+   later closed.  Returns a mapping identifier, or -1 if FILE is
+   empty or if the mapping would overlap any existing page or the
+   heap. */
+int
+mmap_map (struct file *file, void *addr)
+{
+  struct thread *t = thread_current ();
+  struct mapping *m;
+  off_t length;
+  size_t i;
+
+  if (addr == NULL || pg_ofs (addr) != 0)
+    return -1;
+
+  m = malloc (sizeof *m);
+  if (m == NULL)
+    return -1;
+
+  lock_acquire (&filesys_lock);
+  m->file = file_reopen (file);
+  length = m->file != NULL ? file_length (m->file) : 0;
+  lock_release (&filesys_lock);
+  if (length == 0)
+    goto fail;
+
+  m->mapid = t->next_mapid++;
+  m->base = addr;
+  m->page_cnt = 0;
+  list_push_back (&t->mappings, &m->elem);
+
+  for (i = 0; i * PGSIZE < (size_t) length; i++)
+    {
+      uint8_t *upage = m->base + i * PGSIZE;
+      off_t ofs = i * PGSIZE;
+      struct page *p;
+
+      if (!is_user_vaddr (upage)
+          || (upage >= t->heap_start
+              && upage < (uint8_t *) pg_round_up (t->heap_brk))
+          || (p = page_alloc (upage, true)) == NULL)
+        {
+          unmap (m);
+          return -1;
+        }
+      p->file = m->file;
+      p->file_ofs = ofs;
+      p->read_bytes = length - ofs < PGSIZE ? length - ofs : PGSIZE;
+      p->mapped = true;
+      m->page_cnt++;
+    }
+  return m->mapid;
+
+ fail:
+  lock_acquire (&filesys_lock);
+  file_close (m->file);
+  lock_release (&filesys_lock);
+  free (m);
+  return -1;
+}
+
+/* Removes mapping MAPID from the current process, writing back
+   any pages that were modified.  Does nothing if there is no
+   such mapping. */
+void
+mmap_unmap (int mapid)
+{
+  struct thread *t = thread_current ();
+  struct list_elem *e;
+
+  for (e = list_begin (&t->mappings); e != list_end (&t->mappings);
+       e = list_next (e))
+    {
+      struct mapping *m = list_entry (e, struct mapping, elem);
+      if (m->mapid == mapid)
+        {
+          unmap (m);
+          return;
+        }
+    }
+}
+
+/* Frees all of the current process's mappings.  Called when the
+   process exits, after page_table_destroy() has already written
+   back and freed their pages. */
+void
+mmap_destroy (void)
+{
+  struct thread *t = thread_current ();
+
+  while (!list_empty (&t->mappings))
+    {
+      struct list_elem *e = list_pop_front (&t->mappings);
+      struct mapping *m = list_entry (e, struct mapping, elem);
+
+      lock_acquire (&filesys_lock);
+      file_close (m->file);
+      lock_release (&filesys_lock);
+      free (m);
+    }
+}
+
+/* Removes the pages of mapping M from the current process,
+   writing back those that were modified, and frees M. */
+static void
+unmap (struct mapping *m)
+{
+  size_t i;
+
+  for (i = 0; i < m->page_cnt; i++)
+    page_free (page_lookup (m->base + i * PGSIZE));
+
+  list_remove (&m->elem);
+  lock_acquire (&filesys_lock);
+  file_close (m->file);
+  lock_release (&filesys_lock);
+  free (m);
+}
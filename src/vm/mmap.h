@@ -0,0 +1,13 @@
+#ifndef VM_MMAP_H
+#define VM_MMAP_H
+
+#include <stdbool.h>
+
+struct file;
+
+int mmap_map (struct file *, void *addr);
+void mmap_unmap (int mapid);
+void mmap_destroy (void);
+bool mmap_overlaps (const void *start, const void *end);
+
+#endif /* vm/mmap.h */
@@ -0,0 +1,732 @@
+#include "vm/page.h"
+#include <debug.h>
+#include <madvise.h>
+#include <round.h>
+#include <string.h>
+#include <vdso.h>
+#include "devices/timer.h"
+#include "filesys/file.h"
+#include "filesys/filesys.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "userprog/process.h"
+#include "vm/frame.h"
+#include "vm/prefetch.h"
+#include "vm/share.h"
+#include "vm/zswap.h"
+
+/* Readahead window for sequential faults, in pages.  The window
+   starts at RA_MIN pages and doubles on each sequential fault up
+   to RA_MAX. */
+#define RA_MIN 4
+#define RA_MAX 32
+
+/* Minimum time between working set samples, in timer ticks. */
+#define WS_INTERVAL (TIMER_FREQ / 4)
+
+/* Size of the window of file pages mapped together on each
+   fault on a file-backed page, set with -faultaround=N.  0 or 1
+   disables fault-around. */
+int page_fault_around;
+
+/* A page of zeros, mapped read-only in place of every zero-fill
+   page that has been read but not yet written. */
+static void *zero_page;
+
+static hash_hash_func page_hash;
+static hash_less_func page_less;
+static hash_action_func page_destroy;
+static struct page *lookup (struct thread *, const void *uaddr);
+static bool page_load (struct thread *, struct page *, bool write,
+                       bool *io);
+static void page_unload (struct page *, uint32_t *pd);
+static uint8_t *fault_around (struct thread *, struct page *);
+static void readahead (struct thread *, uint8_t *upage, uint8_t *mapped_end,
+                       bool write, bool advised);
+static void drop_behind (struct thread *, uint8_t *upage);
+static bool add_zero_page (struct thread *, void *upage, bool write);
+
+/* Initializes the shared zero page. */
+void
+page_init (void)
+{
+  zero_page = palloc_get_page (PAL_ASSERT | PAL_ZERO);
+}
+
+/* Initializes PAGES as an empty supplemental page table. */
+void
+page_table_init (struct hash *pages)
+{
+  hash_init (pages, page_hash, page_less, NULL);
+}
+
+/* Page directory passed to page_destroy(). */
+static uint32_t *destroy_pd;
+
+/* Frees every page in the current process's supplemental page
+   table PAGES, along with the frames they occupy, and unmaps them
+   from page directory PD.  PD must not be the active page
+   directory. */
+void
+page_table_destroy (struct hash *pages, uint32_t *pd)
+{
+  struct lock *page_lock = &thread_current ()->page_lock;
+
+  /* Holding the page lock keeps the evictor away from the pages
+     while they are freed. */
+  lock_acquire (page_lock);
+  destroy_pd = pd;
+  hash_destroy (pages, page_destroy);
+  lock_release (page_lock);
+}
+
+/* Frees the page in E, as part of page_table_destroy(). */
+static void
+page_destroy (struct hash_elem *e, void *aux UNUSED)
+{
+  struct page *p = hash_entry (e, struct page, hash_elem);
+  page_unload (p, destroy_pd);
+  free (p);
+}
+
+/* Evicts page P from memory, if it is resident, and unmaps it
+   from page directory PD.  The contents of a modified
+   memory-mapped page are written back to its file, and any
+   swapped-out copy is discarded, so that a page with a backing
+   file reads it again. */
+static void
+page_unload (struct page *p, uint32_t *pd)
+{
+  zswap_discard (p->swap);
+  p->swap = NULL;
+  p->modified = false;
+
+  if (p->zero_mapped)
+    {
+      pagedir_clear_page (pd, p->upage);
+      p->zero_mapped = false;
+    }
+  else if (p->share != NULL)
+    {
+      pagedir_clear_page (pd, p->upage);
+      share_release (p->share);
+      p->share = NULL;
+      p->thread->rusage.resident_pages--;
+    }
+  else if (p->frame != NULL)
+    {
+      if (p->mapped && pagedir_is_dirty (pd, p->upage))
+        {
+          lock_acquire (&filesys_lock);
+          file_write_at (p->file, p->frame->kpage, p->read_bytes,
+                         p->file_ofs);
+          lock_release (&filesys_lock);
+        }
+
+      /* Unmap before freeing, so that pagedir_destroy() does not
+         free the frame a second time. */
+      pagedir_clear_page (pd, p->upage);
+      frame_free (p->frame);
+      p->frame = NULL;
+      p->thread->rusage.resident_pages--;
+    }
+}
+
+/* Adds a page at user virtual address UPAGE to the current
+   process's supplemental page table.  The page initially has no
+   backing file, so it reads as zeros unless the caller fills in
+   the file members.  Returns the new page, or a null pointer if
+   UPAGE is already in use, including by the vDSO page, or memory
+   is exhausted. */
+struct page *
+page_alloc (void *upage, bool writable)
+{
+  struct thread *t = thread_current ();
+  struct hash_elem *old;
+  struct page *p;
+
+  ASSERT (pg_ofs (upage) == 0);
+  ASSERT (is_user_vaddr (upage));
+
+  if (upage == VDSO_ADDR)
+    return NULL;
+
+  p = malloc (sizeof *p);
+  if (p == NULL)
+    return NULL;
+
+  p->upage = upage;
+  p->thread = t;
+  p->writable = writable;
+  p->frame = NULL;
+  p->share = NULL;
+  p->swap = NULL;
+  p->file = NULL;
+  p->file_ofs = 0;
+  p->read_bytes = 0;
+  p->mapped = false;
+  p->modified = false;
+  p->zero_mapped = false;
+  p->sequential = false;
+  p->referenced = false;
+  p->seen = t->ws_epoch - 1;
+
+  lock_acquire (&t->page_lock);
+  old = hash_insert (&t->pages, &p->hash_elem);
+  lock_release (&t->page_lock);
+  if (old != NULL)
+    {
+      free (p);
+      return NULL;
+    }
+  return p;
+}
+
+/* Removes page P from the current process's address space,
+   writing it back first if it is a modified memory-mapped page,
+   and frees it. */
+void
+page_free (struct page *p)
+{
+  struct thread *t = thread_current ();
+
+  lock_acquire (&t->page_lock);
+  page_unload (p, t->pagedir);
+  hash_delete (&t->pages, &p->hash_elem);
+  lock_release (&t->page_lock);
+  free (p);
+}
+
+/* Returns the page containing user virtual address UADDR in the
+   current process's supplemental page table, or a null pointer
+   if there is no such page.
+
+   Only the process itself adds or removes pages, so it may look
+   them up without holding its page lock. */
+struct page *
+page_lookup (const void *uaddr)
+{
+  return lookup (thread_current (), uaddr);
+}
+
+/* Returns the page containing UADDR in T's supplemental page
+   table, or a null pointer if there is no such page. */
+static struct page *
+lookup (struct thread *t, const void *uaddr)
+{
+  struct page key;
+  struct hash_elem *e;
+
+  key.upage = pg_round_down (uaddr);
+  e = hash_find (&t->pages, &key.hash_elem);
+  return e != NULL ? hash_entry (e, struct page, hash_elem) : NULL;
+}
+
+/* Returns true if page P is mapped into its process's page
+   directory. */
+static inline bool
+is_resident (const struct page *p)
+{
+  return p->frame != NULL || p->share != NULL || p->zero_mapped;
+}
+
+/* Brings page P into memory and maps it into T's page
+   directory, for writing if WRITE is true.  T's page lock must
+   be held.  Sets *IO to true if the page had to be read from
+   disk, false otherwise.  Returns true if successful. */
+static bool
+page_load (struct thread *t, struct page *p, bool write, bool *io)
+{
+  uint32_t *pd = t->pagedir;
+
+  ASSERT (lock_held_by_current_thread (&t->page_lock));
+  ASSERT (!is_resident (p));
+
+  *io = false;
+
+  /* A page that was swapped out comes back from swap.  The saved
+     copy is discarded only once the page is mapped again. */
+  if (p->swap != NULL)
+    {
+      p->frame = frame_alloc (p, false);
+      if (p->frame == NULL)
+        return false;
+      *io = zswap_load (p->swap, p->frame->kpage);
+      if (!pagedir_set_page (pd, p->upage, p->frame->kpage, p->writable))
+        goto fail;
+      zswap_discard (p->swap);
+      p->swap = NULL;
+      t->rusage.swap_ins++;
+      t->rusage.resident_pages++;
+      return true;
+    }
+
+  /* Read-only file pages come from the shared page cache. */
+  if (p->file != NULL && !p->writable)
+    {
+      p->share = share_acquire (p->file, p->file_ofs, p->read_bytes, io);
+      if (p->share == NULL)
+        return false;
+      if (!pagedir_set_page (pd, p->upage, p->share->frame->kpage, false))
+        {
+          share_release (p->share);
+          p->share = NULL;
+          return false;
+        }
+      t->rusage.resident_pages++;
+      return true;
+    }
+
+  /* A zero-fill page that is only being read maps the zero page,
+     until the first write to it faults in a frame of its own. */
+  if (p->file == NULL && (!write || !p->writable))
+    {
+      if (!pagedir_set_page (pd, p->upage, zero_page, false))
+        return false;
+      p->zero_mapped = true;
+      return true;
+    }
+
+  p->frame = frame_alloc (p, p->file == NULL);
+  if (p->frame == NULL)
+    return false;
+
+  if (p->file != NULL)
+    {
+      off_t bytes_read;
+
+      *io = true;
+      lock_acquire (&filesys_lock);
+      bytes_read = file_read_at (p->file, p->frame->kpage, p->read_bytes,
+                                 p->file_ofs);
+      lock_release (&filesys_lock);
+      if (bytes_read != (off_t) p->read_bytes)
+        goto fail;
+      memset ((uint8_t *) p->frame->kpage + p->read_bytes, 0,
+              PGSIZE - p->read_bytes);
+    }
+
+  if (!pagedir_set_page (pd, p->upage, p->frame->kpage, p->writable))
+    goto fail;
+  t->rusage.resident_pages++;
+  return true;
+
+ fail:
+  frame_free (p->frame);
+  p->frame = NULL;
+  return false;
+}
+
+/* Handles a fault at FAULT_ADDR, a write fault if WRITE is true,
+   by loading the page that contains it, if the current process
+   has such a page.  A write to a page that maps the zero page
+   gets the page a frame of its own.  Also maps neighbouring
+   pages of the same file, if fault-around is enabled, and starts
+   reading ahead if the process appears to be faulting its way
+   sequentially through memory.  Returns true if successful,
+   false if FAULT_ADDR is not part of the process's address space
+   or the page cannot be loaded. */
+bool
+page_in (void *fault_addr, bool write)
+{
+  struct thread *t = thread_current ();
+  struct page *p;
+  uint8_t *mapped_end = NULL;
+  bool io = false;
+  bool success;
+
+  if (t->pagedir == NULL)
+    return false;
+
+  page_sample_working_set ();
+
+  lock_acquire (&t->page_lock);
+  p = lookup (t, fault_addr);
+  if (p == NULL || (write && !p->writable))
+    success = false;
+  else if (is_resident (p) && !(write && p->zero_mapped))
+    {
+      /* Another thread, such as the prefetch thread, brought the
+         page in while we waited for the lock. */
+      success = true;
+    }
+  else
+    {
+      if (p->zero_mapped)
+        page_unload (p, t->pagedir);
+      success = page_load (t, p, write, &io);
+      if (success)
+        mapped_end = fault_around (t, p);
+      if (success && p->sequential)
+        drop_behind (t, p->upage);
+    }
+  if (success)
+    {
+      if (io)
+        t->rusage.major_faults++;
+      else
+        t->rusage.minor_faults++;
+    }
+  lock_release (&t->page_lock);
+
+  if (mapped_end != NULL)
+    readahead (t, p->upage, mapped_end, write, p->sequential);
+  return success;
+}
+
+/* Maps the other pages of P's file that lie in the aligned
+   window of page_fault_around pages containing page P, which T
+   has just faulted in.  Mapping pages that are already in the
+   shared page cache or adjacent on disk costs far less than
+   taking a separate fault on each of them.  Returns the end of
+   the run of resident pages that starts at P. */
+static uint8_t *
+fault_around (struct thread *t, struct page *p)
+{
+  size_t window = page_fault_around;
+  uint8_t *first, *last, *upage;
+  uint8_t *end = (uint8_t *) p->upage + PGSIZE;
+
+  if (page_fault_around <= 1 || p->file == NULL)
+    return end;
+
+  first = (uint8_t *) p->upage - pg_no (p->upage) % window * PGSIZE;
+  last = first + (window - 1) * PGSIZE;
+  for (upage = first; upage <= last && is_user_vaddr (upage);
+       upage += PGSIZE)
+    {
+      struct page *q = lookup (t, upage);
+      bool io;
+
+      if (q == NULL || q->file != p->file)
+        continue;
+      if (!is_resident (q) && !page_load (t, q, false, &io))
+        break;
+      if (upage == end)
+        end += PGSIZE;
+    }
+  return end;
+}
+
+/* Records a fault by T on UPAGE, a write fault if WRITE is true,
+   after which every page from UPAGE up to MAPPED_END is
+   resident.  A fault just past the
+   previous fault, or inside the window already read ahead for
+   it, is taken to be part of a sequential scan: the readahead
+   window then grows and the pages beyond MAPPED_END are handed
+   to the prefetch thread, so that they are likely to be in
+   memory by the time the process reaches them, loaded for
+   writing if the fault was a write.  Any other fault resets the
+   window.  If ADVISED is true, because UPAGE lies in a region
+   that T advised would be accessed sequentially, the full
+   RA_MAX window is read ahead on every fault. */
+static void
+readahead (struct thread *t, uint8_t *upage, uint8_t *mapped_end,
+           bool write, bool advised)
+{
+  bool following = upage > t->fault_last && upage <= t->ra_next;
+
+  t->fault_last = upage;
+  if (!following && !advised)
+    {
+      t->ra_pages = 0;
+      t->ra_next = mapped_end;
+      return;
+    }
+
+  if (advised)
+    t->ra_pages = RA_MAX;
+  else
+    t->ra_pages = t->ra_pages == 0 ? RA_MIN : t->ra_pages * 2;
+  if (t->ra_pages > RA_MAX)
+    t->ra_pages = RA_MAX;
+
+  if (t->ra_next < mapped_end || !following)
+    t->ra_next = mapped_end;
+  if (t->ra_next < upage + t->ra_pages * PGSIZE)
+    {
+      uint8_t *end = upage + t->ra_pages * PGSIZE;
+      prefetch_request (t, t->ra_next, (end - t->ra_next) / PGSIZE, write);
+      t->ra_next = end;
+    }
+}
+
+/* Clears the accessed bits, including any set aside by the
+   working set sampler, of T's resident pages that lie between
+   RA_MAX and 2 * RA_MAX pages behind UPAGE, in a region that T
+   advised would be accessed sequentially, so that the clock
+   evicts them ahead of pages that may still be needed.  T's page
+   lock must be held. */
+static void
+drop_behind (struct thread *t, uint8_t *upage)
+{
+  size_t i;
+
+  for (i = RA_MAX; i < 2 * RA_MAX && i <= pg_no (upage); i++)
+    {
+      struct page *q = lookup (t, upage - i * PGSIZE);
+      if (q != NULL && q->sequential && q->frame != NULL)
+        {
+          if (pagedir_is_accessed (t->pagedir, q->upage))
+            pagedir_set_accessed (t->pagedir, q->upage, false);
+          q->referenced = false;
+        }
+    }
+}
+
+/* Loads the page at UPAGE in T's address space, for writing if
+   WRITE is true, if T has such a page and it is not already
+   resident.  Called by the prefetch thread, not by T.  Returns
+   false if the page exists but could not be loaded, true
+   otherwise. */
+bool
+page_prefetch (struct thread *t, void *upage, bool write)
+{
+  struct page *p;
+  bool io;
+  bool success = true;
+
+  lock_acquire (&t->page_lock);
+  p = lookup (t, upage);
+  if (p != NULL && !is_resident (p))
+    success = page_load (t, p, write, &io);
+  lock_release (&t->page_lock);
+
+  return success;
+}
+
+/* Evicts page P, which must have a private frame, from memory,
+   where P's process has page directory PD.  The process's page
+   lock must be held.  A memory-mapped page is written back to
+   its file if it was modified, and any other page that was
+   modified, now or before an earlier swap-in, or has no backing
+   file is swapped out; the rest can simply be read again.  Returns true if successful, in which
+   case P no longer owns its frame and the caller may reuse the
+   frame's memory.  Returns false if there is no room in swap. */
+bool
+page_evict (struct page *p, uint32_t *pd)
+{
+  bool dirty;
+
+  ASSERT (p->frame != NULL);
+  ASSERT (lock_held_by_current_thread (&p->thread->page_lock));
+
+  /* Unmap the page before looking at the dirty bit, so that the
+     process cannot modify it behind our back.  Clearing the page
+     leaves the dirty bit intact. */
+  pagedir_clear_page (pd, p->upage);
+  dirty = pagedir_is_dirty (pd, p->upage);
+
+  if (p->mapped)
+    {
+      if (dirty)
+        {
+          lock_acquire (&filesys_lock);
+          file_write_at (p->file, p->frame->kpage, p->read_bytes,
+                         p->file_ofs);
+          lock_release (&filesys_lock);
+        }
+    }
+  else if (dirty || p->modified || p->file == NULL)
+    {
+      p->swap = zswap_store (p->frame->kpage);
+      if (p->swap == NULL)
+        {
+          pagedir_set_page (pd, p->upage, p->frame->kpage, p->writable);
+          pagedir_set_dirty (pd, p->upage, dirty);
+          return false;
+        }
+
+      /* The file no longer holds the page's contents, but stays
+         attached so that MADV_DONTNEED can read it again. */
+      p->modified = true;
+    }
+
+  p->frame = NULL;
+  p->thread->rusage.evictions++;
+  p->thread->rusage.resident_pages--;
+  return true;
+}
+
+/* Handles a not-present fault at FAULT_ADDR that might be an
+   attempt to grow the stack, given user stack pointer ESP.
+   Accesses up to 32 bytes below ESP are allowed, because PUSHA
+   checks permissions before it adjusts the stack pointer.  WRITE
+   is true for a write fault.  Returns true if a new stack page
+   was added and mapped. */
+bool
+page_grow_stack (void *fault_addr, const void *esp, bool write)
+{
+  struct thread *t = thread_current ();
+  uint8_t *addr = fault_addr;
+
+  if (t->pagedir == NULL
+      || !is_user_vaddr (addr)
+      || addr < (uint8_t *) PHYS_BASE - STACK_MAX
+      || addr + 32 < (const uint8_t *) esp)
+    return false;
+  return add_zero_page (t, pg_round_down (addr), write);
+}
+
+/* Handles a not-present fault at FAULT_ADDR that might be the
+   first access to a page of the heap, which sbrk() extends only
+   by moving the break.  WRITE is true for a write fault.  Returns
+   true if a new heap page was added and mapped. */
+bool
+page_grow_heap (void *fault_addr, bool write)
+{
+  struct thread *t = thread_current ();
+  uint8_t *addr = fault_addr;
+
+  if (t->pagedir == NULL
+      || addr < t->heap_start
+      || addr >= (uint8_t *) pg_round_up (t->heap_brk))
+    return false;
+  return add_zero_page (t, pg_round_down (addr), write);
+}
+
+/* Adds a zeroed, writable page at UPAGE to T, which must be the
+   current thread, and maps it, for writing if WRITE is true.
+   Returns true if successful. */
+static bool
+add_zero_page (struct thread *t, void *upage, bool write)
+{
+  struct page *p;
+  bool io;
+  bool success;
+
+  p = page_alloc (upage, true);
+  if (p == NULL)
+    return false;
+
+  lock_acquire (&t->page_lock);
+  success = page_load (t, p, write, &io);
+  if (success)
+    t->rusage.minor_faults++;
+  lock_release (&t->page_lock);
+  if (!success)
+    page_free (p);
+  return success;
+}
+
+/* Updates the current process's working set size, the number of
+   its resident pages that it has accessed since the previous
+   sample, and clears their accessed bits for the next sample.
+   Does nothing if the previous sample was taken less than
+   WS_INTERVAL ticks ago, so that it is cheap to call on every
+   entry to the kernel.
+
+   The evictor relies on the same accessed bits for its second
+   chance, so each bit cleared here is moved to the page's
+   `referenced' flag, which the evictor honors in the same way.
+   A page whose bit the evictor cleared since the previous sample
+   is recognized by its `seen' epoch. */
+void
+page_sample_working_set (void)
+{
+  struct thread *t = thread_current ();
+  struct hash_iterator i;
+  unsigned accessed = 0;
+
+  if (t->pagedir == NULL || timer_elapsed (t->ws_sampled) < WS_INTERVAL)
+    return;
+  t->ws_sampled = timer_ticks ();
+
+  lock_acquire (&t->page_lock);
+  hash_first (&i, &t->pages);
+  while (hash_next (&i))
+    {
+      struct page *p = hash_entry (hash_cur (&i), struct page, hash_elem);
+      if (p->frame == NULL && p->share == NULL)
+        continue;
+      if (pagedir_test_and_clear_accessed (t->pagedir, p->upage))
+        {
+          p->referenced = true;
+          accessed++;
+        }
+      else if (p->seen == t->ws_epoch)
+        accessed++;
+    }
+  pagedir_flush (t->pagedir);
+  t->ws_epoch++;
+  t->rusage.working_set = accessed;
+  lock_release (&t->page_lock);
+}
+
+/* Applies ADVICE, one of the MADV_* values, to the pages that
+   span the LENGTH bytes starting at ADDR, which must be page
+   aligned, in the current process:
+
+   - MADV_NORMAL and MADV_SEQUENTIAL set whether faults on the
+     pages read ahead as far as possible and let the pages left
+     behind be evicted early.
+
+   - MADV_WILLNEED asks the prefetch thread to load the pages.
+
+   - MADV_DONTNEED drops the pages from memory at once, writing
+     back modified memory-mapped pages.  Other pages read from
+     their file again when next touched, or as zeros if they
+     have none.
+
+   Returns false if ADVICE is not valid or if any of the pages is
+   not part of the process's address space. */
+bool
+page_advise (void *addr, size_t length, int advice)
+{
+  struct thread *t = thread_current ();
+  uint8_t *first = addr;
+  size_t page_cnt = DIV_ROUND_UP (length, PGSIZE);
+  size_t i;
+
+  if (pg_ofs (addr) != 0 || !is_user_vaddr (addr)
+      || page_cnt > pg_no (PHYS_BASE) - pg_no (addr)
+      || advice < MADV_NORMAL || advice > MADV_DONTNEED)
+    return false;
+  for (i = 0; i < page_cnt; i++)
+    if (lookup (t, first + i * PGSIZE) == NULL)
+      return false;
+
+  switch (advice)
+    {
+    case MADV_NORMAL:
+    case MADV_SEQUENTIAL:
+      for (i = 0; i < page_cnt; i++)
+        lookup (t, first + i * PGSIZE)->sequential
+          = advice == MADV_SEQUENTIAL;
+      break;
+
+    case MADV_WILLNEED:
+      prefetch_request (t, first, page_cnt, false);
+      break;
+
+    case MADV_DONTNEED:
+      lock_acquire (&t->page_lock);
+      for (i = 0; i < page_cnt; i++)
+        page_unload (lookup (t, first + i * PGSIZE), t->pagedir);
+      lock_release (&t->page_lock);
+      break;
+    }
+  return true;
+}
+
+/* Returns a hash value for the page in E. */
+static unsigned
+page_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  const struct page *p = hash_entry (e, struct page, hash_elem);
+  return hash_bytes (&p->upage, sizeof p->upage);
+}
+
+/* Returns true if page A precedes page B. */
+static bool
+page_less (const struct hash_elem *a_, const struct hash_elem *b_,
+           void *aux UNUSED)
+{
+  const struct page *a = hash_entry (a_, struct page, hash_elem);
+  const struct page *b = hash_entry (b_, struct page, hash_elem);
+
+  return a->upage < b->upage;
+}
@@ -0,0 +1,56 @@
+#ifndef VM_PAGE_H
+#define VM_PAGE_H
+
+#include <hash.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "filesys/off_t.h"
+
+struct file;
+struct thread;
+
+/* A virtual page in a process's supplemental page table.
+
+   Describes where the page's contents come from, so that the
+   page can be brought into memory when it is first accessed. */
+struct page
+  {
+    void *upage;                /* User virtual address. */
+    struct thread *thread;      /* Owning process. */
+    bool writable;              /* Writable by the user process? */
+    struct frame *frame;        /* Private frame, or null. */
+    struct share *share;        /* Shared read-only frame, or null. */
+    struct zswap *swap;         /* Swapped-out contents, or null. */
+
+    /* Backing file, if any.  A page with no file is zeroed. */
+    struct file *file;          /* File to read from. */
+    off_t file_ofs;             /* Offset of page within FILE. */
+    uint32_t read_bytes;        /* Bytes to read; the rest is zeroed. */
+    bool mapped;                /* Memory-mapped: write back to FILE? */
+    bool modified;              /* Private copy differs from FILE? */
+    bool zero_mapped;           /* Mapped to the shared zero page? */
+    bool sequential;            /* Advised to expect sequential access? */
+    bool referenced;            /* Accessed bit set aside by sampler. */
+    unsigned seen;              /* Owner's `ws_epoch' when the evictor
+                                   last found the page accessed. */
+
+    struct hash_elem hash_elem; /* struct thread `pages' element. */
+  };
+
+extern int page_fault_around;
+
+void page_init (void);
+void page_table_init (struct hash *);
+void page_table_destroy (struct hash *, uint32_t *pd);
+struct page *page_alloc (void *upage, bool writable);
+void page_free (struct page *);
+struct page *page_lookup (const void *uaddr);
+bool page_in (void *fault_addr, bool write);
+bool page_grow_stack (void *fault_addr, const void *esp, bool write);
+bool page_grow_heap (void *fault_addr, bool write);
+bool page_prefetch (struct thread *, void *upage, bool write);
+bool page_evict (struct page *, uint32_t *pd);
+void page_sample_working_set (void);
+bool page_advise (void *addr, size_t length, int advice);
+
+#endif /* vm/page.h */
@@ -0,0 +1,137 @@
+#include "vm/prefetch.h"
+#include <debug.h>
+#include <list.h>
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "vm/page.h"
+
+/* Asynchronous page prefetching.
+
+   When a process faults its way sequentially through memory,
+   page_in() asks for the pages ahead of the fault to be loaded.
+   A kernel thread does the loading, so that the process keeps
+   running while the pages are read in. */
+
+/* A range of pages to load into a process's address space. */
+struct request
+  {
+    struct thread *thread;      /* Process to load pages for. */
+    uint8_t *upage;             /* First page to load. */
+    size_t page_cnt;            /* Number of pages to load. */
+    bool write;                 /* Load pages for writing? */
+    struct list_elem elem;      /* `requests' element. */
+  };
+
+static struct list requests;    /* Pending requests. */
+static struct lock prefetch_lock;
+static struct condition work;   /* Signaled when a request arrives. */
+static struct condition idle;   /* Signaled when `current' finishes. */
+
+/* Request being worked on, or null.  Its pages are loaded one at
+   a time, so that prefetch_cancel() can stop it partway. */
+static struct request *current;
+
+static thread_func prefetch_thread;
+
+/* Initializes the prefetcher and starts its thread. */
+void
+prefetch_init (void)
+{
+  list_init (&requests);
+  lock_init (&prefetch_lock);
+  cond_init (&work);
+  cond_init (&idle);
+  thread_create ("prefetch", PRI_DEFAULT, prefetch_thread, NULL);
+}
+
+/* Asks for the PAGE_CNT pages starting at UPAGE in process T's
+   address space to be loaded in the background, for writing if
+   WRITE is true.  The request is dropped if memory is short. */
+void
+prefetch_request (struct thread *t, void *upage, size_t page_cnt,
+                  bool write)
+{
+  struct request *r;
+
+  if (page_cnt == 0)
+    return;
+
+  r = malloc (sizeof *r);
+  if (r == NULL)
+    return;
+  r->thread = t;
+  r->upage = upage;
+  r->page_cnt = page_cnt;
+  r->write = write;
+
+  lock_acquire (&prefetch_lock);
+  list_push_back (&requests, &r->elem);
+  cond_signal (&work, &prefetch_lock);
+  lock_release (&prefetch_lock);
+}
+
+/* Discards all of T's pending requests and waits for the one in
+   progress, if any, to stop.  Must be called before T's address
+   space is torn down. */
+void
+prefetch_cancel (struct thread *t)
+{
+  struct list_elem *e, *next;
+
+  lock_acquire (&prefetch_lock);
+  for (e = list_begin (&requests); e != list_end (&requests); e = next)
+    {
+      struct request *r = list_entry (e, struct request, elem);
+      next = list_next (e);
+      if (r->thread == t)
+        {
+          list_remove (e);
+          free (r);
+        }
+    }
+  while (current != NULL && current->thread == t)
+    {
+      current->page_cnt = 0;
+      cond_wait (&idle, &prefetch_lock);
+    }
+  lock_release (&prefetch_lock);
+}
+
+/* Prefetch thread.  Loads the pages of each request in turn,
+   giving up on a request at the first page that cannot be
+   loaded. */
+static void
+prefetch_thread (void *aux UNUSED)
+{
+  for (;;)
+    {
+      struct request *r;
+
+      lock_acquire (&prefetch_lock);
+      while (list_empty (&requests))
+        cond_wait (&work, &prefetch_lock);
+      r = current = list_entry (list_pop_front (&requests),
+                                struct request, elem);
+      while (r->page_cnt > 0)
+        {
+          void *upage = r->upage;
+          bool ok;
+
+          lock_release (&prefetch_lock);
+          ok = page_prefetch (r->thread, upage, r->write);
+          lock_acquire (&prefetch_lock);
+
+          r->upage += PGSIZE;
+          if (ok && r->page_cnt > 0)
+            r->page_cnt--;
+          else
+            r->page_cnt = 0;
+        }
+      current = NULL;
+      cond_broadcast (&idle, &prefetch_lock);
+      lock_release (&prefetch_lock);
+      free (r);
+    }
+}
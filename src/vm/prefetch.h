@@ -0,0 +1,14 @@
+#ifndef VM_PREFETCH_H
+#define VM_PREFETCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+struct thread;
+
+void prefetch_init (void);
+void prefetch_request (struct thread *, void *upage, size_t page_cnt,
+                       bool write);
+void prefetch_cancel (struct thread *);
+
+#endif /* vm/prefetch.h */
@@ -0,0 +1,136 @@
+#include "vm/share.h"
+#include <debug.h>
+#include <string.h>
+#include "filesys/file.h"
+#include "filesys/filesys.h"
+#include "filesys/inode.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+#include "vm/frame.h"
+
+/* Shared read-only pages.
+
+   The code and other read-only segments of an executable are
+   identical in every process running it, so rather than giving
+   each process a private copy we keep a cache of such pages,
+   keyed by inode number and file offset, and map the same frame
+   read-only into every process that needs it.  A page stays in
+   the cache for as long as at least one process maps it.
+
+   Every process that maps a shared page keeps its executable
+   open with writes denied, so the data in a cached frame cannot
+   go stale. */
+static struct hash shares;
+static struct lock share_lock;
+
+static hash_hash_func share_hash;
+static hash_less_func share_less;
+
+/* Initializes the shared page cache. */
+void
+share_init (void)
+{
+  hash_init (&shares, share_hash, share_less, NULL);
+  lock_init (&share_lock);
+}
+
+/* Returns the shared page for the READ_BYTES bytes at offset OFS
+   in FILE, followed by zeros to the end of the page, reading it
+   from FILE if no process has it mapped yet, in which case *IO
+   is set to true.  Adds a reference to the returned page, which
+   the caller must drop with share_release().  Returns a null
+   pointer if memory allocation or the file read fails. */
+struct share *
+share_acquire (struct file *file, off_t ofs, uint32_t read_bytes, bool *io)
+{
+  struct share key;
+  struct share *s;
+  struct hash_elem *e;
+  off_t bytes_read;
+
+  ASSERT (ofs % PGSIZE == 0);
+  ASSERT (read_bytes <= PGSIZE);
+
+  key.inumber = inode_get_inumber (file_get_inode (file));
+  key.ofs = ofs;
+  key.read_bytes = read_bytes;
+
+  lock_acquire (&share_lock);
+  e = hash_find (&shares, &key.hash_elem);
+  if (e != NULL)
+    {
+      s = hash_entry (e, struct share, hash_elem);
+      s->ref_cnt++;
+      lock_release (&share_lock);
+      return s;
+    }
+
+  s = malloc (sizeof *s);
+  if (s == NULL)
+    goto fail;
+  *s = key;
+  s->ref_cnt = 1;
+  s->frame = frame_alloc (NULL, false);
+  if (s->frame == NULL)
+    goto fail;
+  *io = true;
+  lock_acquire (&filesys_lock);
+  bytes_read = file_read_at (file, s->frame->kpage, read_bytes, ofs);
+  lock_release (&filesys_lock);
+  if (bytes_read != (off_t) read_bytes)
+    goto fail;
+  memset ((uint8_t *) s->frame->kpage + read_bytes, 0, PGSIZE - read_bytes);
+  hash_insert (&shares, &s->hash_elem);
+  lock_release (&share_lock);
+  return s;
+
+ fail:
+  if (s != NULL)
+    frame_free (s->frame);
+  free (s);
+  lock_release (&share_lock);
+  return NULL;
+}
+
+/* Drops a reference to S, freeing its frame once no process maps
+   it any longer. */
+void
+share_release (struct share *s)
+{
+  if (s == NULL)
+    return;
+
+  lock_acquire (&share_lock);
+  if (--s->ref_cnt == 0)
+    {
+      hash_delete (&shares, &s->hash_elem);
+      frame_free (s->frame);
+      free (s);
+    }
+  lock_release (&share_lock);
+}
+
+/* Returns a hash value for the shared page in E. */
+static unsigned
+share_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  const struct share *s = hash_entry (e, struct share, hash_elem);
+  return hash_int (s->inumber) ^ hash_int (s->ofs);
+}
+
+/* Returns true if shared page A precedes shared page B. */
+static bool
+share_less (const struct hash_elem *a_, const struct hash_elem *b_,
+            void *aux UNUSED)
+{
+  const struct share *a = hash_entry (a_, struct share, hash_elem);
+  const struct share *b = hash_entry (b_, struct share, hash_elem);
+
+  if (a->inumber != b->inumber)
+    return a->inumber < b->inumber;
+  else if (a->ofs != b->ofs)
+    return a->ofs < b->ofs;
+  else
+    return a->read_bytes < b->read_bytes;
+}
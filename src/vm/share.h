@@ -0,0 +1,28 @@
+#ifndef VM_SHARE_H
+#define VM_SHARE_H
+
+#include <hash.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "devices/block.h"
+#include "filesys/off_t.h"
+
+struct file;
+
+/* A read-only file page shared by every process that maps it. */
+struct share
+  {
+    block_sector_t inumber;     /* Inode number of backing file. */
+    off_t ofs;                  /* Offset of page within file. */
+    uint32_t read_bytes;        /* Bytes read from file; rest zeroed. */
+    struct frame *frame;        /* Frame holding the page's data. */
+    int ref_cnt;                /* Number of processes mapping page. */
+    struct hash_elem hash_elem; /* `shares' hash element. */
+  };
+
+void share_init (void);
+struct share *share_acquire (struct file *, off_t ofs, uint32_t read_bytes,
+                             bool *io);
+void share_release (struct share *);
+
+#endif /* vm/share.h */
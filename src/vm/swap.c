@@ -0,0 +1,223 @@
+#include "vm/swap.h"
+#include <bitmap.h>
+#include <debug.h>
+#include <list.h>
+#include <stdio.h>
+#include <string.h>
+#include "devices/block.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* Swap device.
+
+   The swap device is divided into page-sized slots, each of
+   which holds one page evicted from memory.  Pages are written
+   in clusters of consecutive slots, each with a single disk
+   request.  Reading a slot also reads the other slots in use in
+   the aligned group of SWAP_CLUSTER slots around it, again with
+   a single request, on the theory that pages swapped out
+   together are likely to be needed together.  The extra pages
+   are kept in a small swap cache until they are asked for.
+
+   All of this is protected by swap_lock, which is held across
+   disk I/O.  That costs nothing, since there is only one disk to
+   wait for, and ensures that the swap cache never holds an old
+   copy of a slot that has since been rewritten. */
+static struct block *swap_device;
+static struct bitmap *used_slots;   /* One bit per slot. */
+static struct lock swap_lock;
+
+/* Number of sectors per page. */
+#define PAGE_SECTORS (PGSIZE / BLOCK_SECTOR_SIZE)
+
+/* A page read ahead from swap. */
+struct cached_page
+  {
+    size_t slot;                /* Swap slot. */
+    void *kpage;                /* Copy of the slot's contents. */
+    struct list_elem elem;      /* `cache' element. */
+  };
+
+/* Swap cache, most recently read first. */
+static struct list cache;
+static size_t cache_cnt;
+
+/* Maximum number of pages in the swap cache. */
+#define CACHE_MAX (2 * SWAP_CLUSTER)
+
+/* Buffer for reading clusters. */
+static uint8_t *read_buf;
+
+/* Statistics. */
+static long long read_cnt, write_cnt;       /* Disk requests. */
+static long long pages_read, pages_written; /* Pages transferred. */
+static long long cache_hit_cnt;             /* Reads served by cache. */
+
+static struct cached_page *cache_find (size_t slot);
+static void cache_remove (struct cached_page *);
+
+/* Initializes the swap device.  With no swap device, every
+   attempt to swap out a page fails. */
+void
+swap_init (void)
+{
+  size_t slot_cnt = 0;
+
+  swap_device = block_get_role (BLOCK_SWAP);
+  if (swap_device != NULL)
+    slot_cnt = block_size (swap_device) / PAGE_SECTORS;
+  used_slots = bitmap_create (slot_cnt);
+  if (used_slots == NULL)
+    PANIC ("swap bitmap creation failed");
+  lock_init (&swap_lock);
+  list_init (&cache);
+  read_buf = palloc_get_multiple (PAL_ASSERT, SWAP_CLUSTER);
+}
+
+/* Writes the PAGE_CNT pages at PAGES, which must be between 1
+   and SWAP_CLUSTER, to consecutive free swap slots with a single
+   request, and returns the first slot.  Returns SWAP_ERROR if
+   there is no run of PAGE_CNT free slots. */
+size_t
+swap_write (const void *pages, size_t page_cnt)
+{
+  size_t slot, i;
+
+  ASSERT (page_cnt >= 1 && page_cnt <= SWAP_CLUSTER);
+
+  lock_acquire (&swap_lock);
+  slot = bitmap_scan_and_flip (used_slots, 0, page_cnt, false);
+  if (slot != BITMAP_ERROR)
+    {
+      for (i = 0; i < page_cnt; i++)
+        ASSERT (cache_find (slot + i) == NULL);
+      block_write_multiple (swap_device, slot * PAGE_SECTORS,
+                            page_cnt * PAGE_SECTORS, pages);
+      write_cnt++;
+      pages_written += page_cnt;
+    }
+  lock_release (&swap_lock);
+
+  return slot != BITMAP_ERROR ? slot : SWAP_ERROR;
+}
+
+/* Reads the page in swap SLOT into KPAGE, from the swap cache if
+   it was read ahead, and otherwise from disk along with its
+   neighbours.  The slot stays in use until it is freed with
+   swap_free().  Returns true if the page had to be read from
+   disk, false if it came from the cache. */
+bool
+swap_read (size_t slot, void *kpage)
+{
+  struct cached_page *c;
+  size_t first, last, s;
+
+  lock_acquire (&swap_lock);
+  ASSERT (bitmap_test (used_slots, slot));
+
+  c = cache_find (slot);
+  if (c != NULL)
+    {
+      memcpy (kpage, c->kpage, PGSIZE);
+      cache_remove (c);
+      cache_hit_cnt++;
+      lock_release (&swap_lock);
+      return false;
+    }
+
+  /* Find the run of slots in use around SLOT, within its aligned
+     cluster, that are not already cached. */
+  first = last = slot;
+  while (first % SWAP_CLUSTER != 0 && bitmap_test (used_slots, first - 1)
+         && cache_find (first - 1) == NULL)
+    first--;
+  while ((last + 1) % SWAP_CLUSTER != 0
+         && last + 1 < bitmap_size (used_slots)
+         && bitmap_test (used_slots, last + 1)
+         && cache_find (last + 1) == NULL)
+    last++;
+
+  block_read_multiple (swap_device, first * PAGE_SECTORS,
+                       (last - first + 1) * PAGE_SECTORS, read_buf);
+  read_cnt++;
+  pages_read += last - first + 1;
+  memcpy (kpage, read_buf + (slot - first) * PGSIZE, PGSIZE);
+
+  /* Cache the neighbours, dropping the oldest cached pages to
+     make room. */
+  for (s = first; s <= last; s++)
+    if (s != slot)
+      {
+        if (cache_cnt >= CACHE_MAX)
+          cache_remove (list_entry (list_back (&cache),
+                                    struct cached_page, elem));
+        c = malloc (sizeof *c);
+        if (c == NULL)
+          break;
+        c->kpage = palloc_get_page (0);
+        if (c->kpage == NULL)
+          {
+            free (c);
+            break;
+          }
+        c->slot = s;
+        memcpy (c->kpage, read_buf + (s - first) * PGSIZE, PGSIZE);
+        list_push_front (&cache, &c->elem);
+        cache_cnt++;
+      }
+  lock_release (&swap_lock);
+  return true;
+}
+
+/* Frees swap SLOT. */
+void
+swap_free (size_t slot)
+{
+  struct cached_page *c;
+
+  lock_acquire (&swap_lock);
+  ASSERT (bitmap_test (used_slots, slot));
+  bitmap_reset (used_slots, slot);
+  c = cache_find (slot);
+  if (c != NULL)
+    cache_remove (c);
+  lock_release (&swap_lock);
+}
+
+/* Prints swap I/O statistics. */
+void
+swap_print_stats (void)
+{
+  printf ("Swap I/O: %lld reads (%lld pages), %lld writes (%lld pages), "
+          "%lld readahead hits\n",
+          read_cnt, pages_read, write_cnt, pages_written, cache_hit_cnt);
+}
+
+/* Returns the swap cache entry for SLOT, or a null pointer if
+   SLOT is not cached.  swap_lock must be held. */
+static struct cached_page *
+cache_find (size_t slot)
+{
+  struct list_elem *e;
+
+  for (e = list_begin (&cache); e != list_end (&cache); e = list_next (e))
+    {
+      struct cached_page *c = list_entry (e, struct cached_page, elem);
+      if (c->slot == slot)
+        return c;
+    }
+  return NULL;
+}
+
+/* Removes C from the swap cache and frees it.  swap_lock must be
+   held. */
+static void
+cache_remove (struct cached_page *c)
+{
+  list_remove (&c->elem);
+  cache_cnt--;
+  palloc_free_page (c->kpage);
+  free (c);
+}
@@ -0,0 +1,20 @@
+#ifndef VM_SWAP_H
+#define VM_SWAP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Returned by swap_write() when the swap device is full. */
+#define SWAP_ERROR SIZE_MAX
+
+/* Largest number of pages transferred in one swap request. */
+#define SWAP_CLUSTER 8
+
+void swap_init (void);
+size_t swap_write (const void *pages, size_t page_cnt);
+bool swap_read (size_t slot, void *kpage);
+void swap_free (size_t slot);
+void swap_print_stats (void);
+
+#endif /* vm/swap.h */
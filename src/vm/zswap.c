@@ -0,0 +1,204 @@
+#include "vm/zswap.h"
+#include <debug.h>
+#include <list.h>
+#include <lz.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/loader.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+#include "vm/swap.h"
+
+/* Compressed swap cache.
+
+   Writing a page to the swap device and reading it back takes
+   two slow PIO transfers.  Most pages compress well, so a page
+   being swapped out is compressed and kept in a pool in memory
+   instead.  When the pool fills up, the pages that have been in
+   it longest are written out to the swap device together, as a
+   cluster.  Pages that do not compress well go straight to the
+   swap device. */
+
+/* A swapped-out page. */
+struct zswap
+  {
+    uint8_t *data;              /* Compressed data, or null if on disk. */
+    size_t size;                /* Size of compressed data. */
+    size_t slot;                /* Swap slot, if on disk. */
+    struct list_elem elem;      /* `pool' element, if in memory. */
+  };
+
+/* Pages that do not compress to this size or smaller are not
+   worth keeping in memory. */
+#define MAX_COMPRESSED (PGSIZE / 2)
+
+static struct lock zswap_lock;
+static struct list pool;        /* Pages in memory, oldest first. */
+static size_t pool_used;        /* Bytes of compressed data in pool. */
+static size_t pool_max;         /* Maximum value of `pool_used'. */
+
+/* Buffers, protected by zswap_lock. */
+static uint8_t scratch[MAX_COMPRESSED];
+static uint8_t lz_work[LZ_WORK_SIZE];
+static uint8_t *cluster_buf;    /* SWAP_CLUSTER pages. */
+
+/* Statistics. */
+static long long compressed_cnt;    /* Pages stored compressed. */
+static long long spilled_cnt;       /* Pages written to swap device. */
+
+static bool write_back (void);
+
+/* Initializes the compressed swap cache.  The pool may hold up
+   to 1/8 as many bytes as there are in RAM. */
+void
+zswap_init (void)
+{
+  lock_init (&zswap_lock);
+  list_init (&pool);
+  pool_max = init_ram_pages * PGSIZE / 8;
+  cluster_buf = palloc_get_multiple (PAL_ASSERT, SWAP_CLUSTER);
+}
+
+/* Saves a copy of the page at KPAGE, in the compressed pool if
+   possible and on the swap device otherwise.  Returns the saved
+   copy, or a null pointer if there is no room for it anywhere. */
+struct zswap *
+zswap_store (const void *kpage)
+{
+  struct zswap *z;
+  size_t size;
+
+  z = malloc (sizeof *z);
+  if (z == NULL)
+    return NULL;
+
+  lock_acquire (&zswap_lock);
+  size = lz_compress (kpage, PGSIZE, scratch, sizeof scratch, lz_work);
+  if (size != 0)
+    {
+      while (pool_used + size > pool_max && write_back ())
+        continue;
+      if (pool_used + size <= pool_max
+          && (z->data = malloc (size)) != NULL)
+        {
+          memcpy (z->data, scratch, size);
+          z->size = size;
+          list_push_back (&pool, &z->elem);
+          pool_used += size;
+          compressed_cnt++;
+          lock_release (&zswap_lock);
+          return z;
+        }
+    }
+  lock_release (&zswap_lock);
+
+  /* Spill to the swap device. */
+  z->data = NULL;
+  z->size = 0;
+  z->slot = swap_write (kpage, 1);
+  if (z->slot == SWAP_ERROR)
+    {
+      free (z);
+      return NULL;
+    }
+  spilled_cnt++;
+  return z;
+}
+
+/* Restores the page saved in Z into KPAGE.  Z remains valid
+   until it is freed with zswap_discard().  Returns true if the
+   page had to be read from the swap device. */
+bool
+zswap_load (struct zswap *z, void *kpage)
+{
+  size_t slot;
+
+  lock_acquire (&zswap_lock);
+  if (z->data != NULL)
+    {
+      if (lz_decompress (z->data, z->size, kpage, PGSIZE) != PGSIZE)
+        PANIC ("compressed swap page corrupted");
+      lock_release (&zswap_lock);
+      return false;
+    }
+  slot = z->slot;
+  lock_release (&zswap_lock);
+
+  return swap_read (slot, kpage);
+}
+
+/* Frees Z. */
+void
+zswap_discard (struct zswap *z)
+{
+  if (z == NULL)
+    return;
+
+  lock_acquire (&zswap_lock);
+  if (z->data != NULL)
+    {
+      list_remove (&z->elem);
+      pool_used -= z->size;
+      free (z->data);
+    }
+  else
+    swap_free (z->slot);
+  lock_release (&zswap_lock);
+  free (z);
+}
+
+/* Prints swap statistics. */
+void
+zswap_print_stats (void)
+{
+  printf ("Swap: %lld pages compressed, %lld written to disk\n",
+          compressed_cnt, spilled_cnt);
+  swap_print_stats ();
+}
+
+/* Makes room in the pool by writing its oldest pages to the swap
+   device as a single cluster.  The cluster shrinks as needed to
+   fit in the free space on the swap device.  Returns true if any
+   pages were written.  zswap_lock must be held. */
+static bool
+write_back (void)
+{
+  struct zswap *victims[SWAP_CLUSTER];
+  struct list_elem *e;
+  size_t cnt, slot, i;
+
+  ASSERT (lock_held_by_current_thread (&zswap_lock));
+
+  cnt = 0;
+  for (e = list_begin (&pool); e != list_end (&pool) && cnt < SWAP_CLUSTER;
+       e = list_next (e))
+    {
+      struct zswap *z = list_entry (e, struct zswap, elem);
+      lz_decompress (z->data, z->size, cluster_buf + cnt * PGSIZE, PGSIZE);
+      victims[cnt++] = z;
+    }
+
+  for (; cnt > 0; cnt /= 2)
+    {
+      slot = swap_write (cluster_buf, cnt);
+      if (slot != SWAP_ERROR)
+        break;
+    }
+  if (cnt == 0)
+    return false;
+
+  for (i = 0; i < cnt; i++)
+    {
+      struct zswap *z = victims[i];
+      list_remove (&z->elem);
+      pool_used -= z->size;
+      free (z->data);
+      z->data = NULL;
+      z->size = 0;
+      z->slot = slot + i;
+    }
+  spilled_cnt += cnt;
+  return true;
+}
@@ -0,0 +1,14 @@
+#ifndef VM_ZSWAP_H
+#define VM_ZSWAP_H
+
+#include <stdbool.h>
+
+struct zswap;
+
+void zswap_init (void);
+struct zswap *zswap_store (const void *kpage);
+bool zswap_load (struct zswap *, void *kpage);
+void zswap_discard (struct zswap *);
+void zswap_print_stats (void);
+
+#endif /* vm/zswap.h */